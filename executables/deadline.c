@@ -0,0 +1,70 @@
+#include <neutrino/syscall.h>
+#include <_null.h>
+#include <string.h>
+#include <stdint.h>
+
+#define DEADLINE_JOBS       50
+#define DEADLINE_TASKS      3
+
+typedef struct __deadline_task {
+    uint64_t runtime;       // budget of every job, in ns
+    uint64_t deadline;      // relative deadline of every job, in ns
+    uint64_t period;        // time between two releases, in ns
+    uint64_t work;          // spin iterations of every job, well below the budget
+} DeadlineTask;
+
+// the total bandwidth (0.55 of a CPU) is admitted even on a single CPU
+static DeadlineTask tasks[DEADLINE_TASKS] = {
+    {.runtime = 2000000,  .deadline = 10000000, .period = 10000000, .work = 20000},
+    {.runtime = 5000000,  .deadline = 20000000, .period = 25000000, .work = 50000},
+    {.runtime = 10000000, .deadline = 40000000, .period = 40000000, .work = 100000}
+};
+
+void deadline_task(uintptr_t argument) {
+    DeadlineTask* task = &tasks[argument];
+    char buf[128];
+
+    SCDeadlineArgs args = {.runtime = task->runtime, .deadline = task->deadline, .period = task->period};
+    if (neutrino_set_deadline(&args) != SYSCALL_SUCCESS) {
+        // every job of a task that was not admitted is counted as missed
+        strf("Deadline task %u was not admitted", buf, argument);
+        neutrino_log(&(SCLogArgs){.msg = buf});
+        neutrino_destroy_task(&(SCExitArgs){.status = DEADLINE_JOBS});
+    }
+
+    // every job spins for its work, then yields to complete before the next release
+    for (size_t job = 0; job < DEADLINE_JOBS; job++) {
+        for (volatile uint64_t i = 0; i < task->work; i++);
+        neutrino_yield(nullptr);
+    }
+
+    neutrino_get_deadline(&args);
+    neutrino_set_deadline(&(SCDeadlineArgs){.runtime = 0});
+
+    strf("Deadline task %u: %u jobs, %u deadline misses", buf, argument, DEADLINE_JOBS, args.misses);
+    neutrino_log(&(SCLogArgs){.msg = buf});
+    neutrino_destroy_task(&(SCExitArgs){.status = args.misses});
+}
+
+int main() {
+    char buf[128];
+    uint32_t tids[DEADLINE_TASKS];
+    uint64_t misses = 0;
+
+    neutrino_log(&(SCLogArgs){.msg = "Deadline test started"});
+
+    for (size_t i = 0; i < DEADLINE_TASKS; i++) {
+        SCThreadArgs thread = {.entry = (uintptr_t)deadline_task, .argument = i};
+        neutrino_thread_create(&thread);
+        tids[i] = thread.tid;
+    }
+
+    for (size_t i = 0; i < DEADLINE_TASKS; i++) {
+        SCWaitArgs wait = {.pid = tids[i]};
+        if (neutrino_thread_join(&wait) == SYSCALL_SUCCESS) misses += wait.status;
+    }
+
+    strf("Deadline test completed with %u deadline misses", buf, misses);
+    neutrino_log(&(SCLogArgs){.msg = buf});
+    return 0;
+}
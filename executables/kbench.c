@@ -0,0 +1,71 @@
+#include <neutrino/syscall.h>
+#include <_null.h>
+#include <string.h>
+#include <stdint.h>
+
+#define KBENCH_ITERATIONS   1000
+#define KBENCH_TOP_TASKS    32
+
+typedef enum __kbench_kind {
+    KBENCH_NOW,
+    KBENCH_YIELD,
+    KBENCH_ALLOC,
+    KBENCH_TOP,
+    KBENCH_FUTEX,
+    KBENCH_KINDS
+} KbenchKind;
+
+static const char* kbench_names[KBENCH_KINDS] = {"now", "yield", "alloc/free", "top", "futex wake"};
+
+static TopTask top_tasks[KBENCH_TOP_TASKS];
+static volatile uint32_t futex_word = 0;
+
+static inline uint64_t rdtsc() {
+    uint32_t low, high;
+    asm volatile("rdtsc" : "=a"(low), "=d"(high));
+    return ((uint64_t)high << 32) | low;
+}
+
+// *Run one iteration of a kernel path
+// @param kind the benchmarked path
+// @return false if the syscall failed
+bool kbench_run(KbenchKind kind) {
+    switch (kind) {
+        case KBENCH_NOW:
+            return neutrino_now(&(SCNowArgs){0}) == SYSCALL_SUCCESS;
+        case KBENCH_YIELD:
+            return neutrino_yield(nullptr) == SYSCALL_SUCCESS;
+        case KBENCH_ALLOC: {
+            SCAllocArgs alloc = {.size = 1, .user = true};
+            if (neutrino_alloc(&alloc) != SYSCALL_SUCCESS) return false;
+            return neutrino_free(&(SCFreeArgs){.pointer = alloc.pointer, .size = 1}) == SYSCALL_SUCCESS;
+        }
+        case KBENCH_TOP:
+            return neutrino_top(&(SCTopArgs){.tasks = top_tasks, .task_count = KBENCH_TOP_TASKS}) == SYSCALL_SUCCESS;
+        default:
+            // nobody waits on the word, the wake only walks its hash bucket
+            return neutrino_futex(&(SCFutexArgs){.op = FUTEX_WAKE, .address = &futex_word, .value = 1}) == SYSCALL_SUCCESS;
+    }
+}
+
+// times the round trip of syscalls exercising the main kernel paths, so that kernel builds can be compared
+int main() {
+    char buf[128];
+
+    neutrino_log(&(SCLogArgs){.msg = "Kernel benchmark started"});
+
+    for (size_t kind = 0; kind < KBENCH_KINDS; kind++) {
+        size_t failed = 0;
+        uint64_t begin = rdtsc();
+
+        for (size_t i = 0; i < KBENCH_ITERATIONS; i++)
+            if (!kbench_run(kind)) failed++;
+
+        uint64_t cycles = rdtsc() - begin;
+        strf("kbench %c: %u cycles per call, %u failed", buf, kbench_names[kind], cycles / KBENCH_ITERATIONS, failed);
+        neutrino_log(&(SCLogArgs){.msg = buf});
+    }
+
+    neutrino_log(&(SCLogArgs){.msg = "Kernel benchmark finished"});
+    return 0;
+}
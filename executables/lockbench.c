@@ -0,0 +1,93 @@
+#include <neutrino/syscall.h>
+#include <neutrino/lock.h>
+#include <neutrino/sync.h>
+#include <_null.h>
+#include <string.h>
+#include <stdint.h>
+
+#define LOCKBENCH_THREADS       4
+#define LOCKBENCH_ITERATIONS    20000
+
+typedef enum __lockbench_kind {
+    LOCKBENCH_TAS,
+    LOCKBENCH_TICKET,
+    LOCKBENCH_MCS,
+    LOCKBENCH_MUTEX,
+    LOCKBENCH_KINDS
+} LockbenchKind;
+
+static const char* lockbench_names[LOCKBENCH_KINDS] = {"test-and-set", "ticket", "MCS", "futex mutex"};
+
+static Lock tas_lock = NewLock;
+static TicketLock ticket = NewTicketLock;
+static McsLock mcs = NewMcsLock;
+static Mutex mutex = NewMutex;
+
+static volatile bool start = false;
+static volatile uint64_t counter = 0;
+static uint64_t cycles[LOCKBENCH_THREADS];
+
+static inline uint64_t rdtsc() {
+    uint32_t low, high;
+    asm volatile("rdtsc" : "=a"(low), "=d"(high));
+    return ((uint64_t)high << 32) | low;
+}
+
+// every thread takes the lock of the benchmarked kind in a tight loop, incrementing the shared counter
+void lockbench_thread(uintptr_t argument) {
+    LockbenchKind kind = argument / LOCKBENCH_THREADS;
+    McsNode node;
+
+    while (!start) asm volatile ("pause");
+    uint64_t begin = rdtsc();
+
+    for (size_t i = 0; i < LOCKBENCH_ITERATIONS; i++) {
+        switch (kind) {
+            case LOCKBENCH_TAS: lock(&tas_lock); counter++; unlock(&tas_lock); break;
+            case LOCKBENCH_TICKET: ticket_lock(&ticket); counter++; ticket_unlock(&ticket); break;
+            case LOCKBENCH_MCS: mcs_lock(&mcs, &node); counter++; mcs_unlock(&mcs, &node); break;
+            default: mutex_lock(&mutex); counter++; mutex_unlock(&mutex); break;
+        }
+    }
+
+    cycles[argument % LOCKBENCH_THREADS] = rdtsc() - begin;
+    neutrino_destroy_task(&(SCExitArgs){.status = 0});
+}
+
+int main() {
+    char buf[128];
+    uint32_t tids[LOCKBENCH_THREADS];
+
+    neutrino_log(&(SCLogArgs){.msg = "Lock contention benchmark started"});
+
+    for (size_t kind = 0; kind < LOCKBENCH_KINDS; kind++) {
+        start = false;
+        counter = 0;
+
+        for (size_t i = 0; i < LOCKBENCH_THREADS; i++) {
+            SCThreadArgs thread = {.entry = (uintptr_t)lockbench_thread, .argument = kind * LOCKBENCH_THREADS + i};
+            neutrino_thread_create(&thread);
+            tids[i] = thread.tid;
+        }
+
+        start = true;
+        for (size_t i = 0; i < LOCKBENCH_THREADS; i++)
+            neutrino_thread_join(&(SCWaitArgs){.pid = tids[i]});
+
+        uint64_t total = 0, slowest = 0;
+        for (size_t i = 0; i < LOCKBENCH_THREADS; i++) {
+            total += cycles[i];
+            if (cycles[i] > slowest) slowest = cycles[i];
+        }
+
+        // the gap between the average and the slowest thread shows the fairness of the lock
+        strf("%c: %u threads, %u cycles per acquisition, slowest thread %u cycles, counter %c", buf,
+             lockbench_names[kind], LOCKBENCH_THREADS, total / (LOCKBENCH_THREADS * LOCKBENCH_ITERATIONS), slowest,
+             (counter == LOCKBENCH_THREADS * LOCKBENCH_ITERATIONS) ? "correct" : "WRONG");
+        neutrino_log(&(SCLogArgs){.msg = buf});
+    }
+
+    // contention of the kernel locks during the benchmark, printed by kernels built with LOCKSTAT=1
+    neutrino_lock_stats(&(SCLockStatsArgs){.command = LOCK_STATS_DUMP});
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include <neutrino/syscall.h>
+#include <neutrino/cpumask.h>
+#include <_null.h>
+#include <string.h>
+#include <stdint.h>
+
+#define SMPTEST_THREADS     4
+#define SMPTEST_ITERATIONS  200000
+#define SMPTEST_SPIN        64
+#define SMPTEST_WINDOW      100000      // cycles, far shorter than a time slice: no task switch fits in it
+
+static TopCpu top_cpus[SMPTEST_THREADS];
+
+static volatile bool start = false;
+static volatile uint64_t progress[SMPTEST_THREADS];
+static uint32_t peers[SMPTEST_THREADS];         // the threads seen running at the same time, one bit each
+
+static inline uint64_t rdtsc() {
+    uint32_t low, high;
+    asm volatile("rdtsc" : "=a"(low), "=d"(high));
+    return ((uint64_t)high << 32) | low;
+}
+
+// every thread advances its own progress counter, watching the others. A counter moving within a window too
+// short for a task switch means its thread runs on another CPU at the same time
+void smptest_thread(uintptr_t index) {
+    uint64_t seen[SMPTEST_THREADS];
+    uint32_t found = 0;
+
+    while (!start) asm volatile ("pause");
+
+    for (size_t i = 0; i < SMPTEST_ITERATIONS; i++) {
+        uint64_t begin = rdtsc();
+        for (size_t j = 0; j < SMPTEST_THREADS; j++) seen[j] = progress[j];
+
+        progress[index]++;
+        for (size_t k = 0; k < SMPTEST_SPIN; k++) asm volatile ("pause");
+
+        if (rdtsc() - begin >= SMPTEST_WINDOW) continue;     // switched out meanwhile, the window proves nothing
+        for (size_t j = 0; j < SMPTEST_THREADS; j++)
+            if (j != index && progress[j] != seen[j]) found |= 1u << j;
+    }
+
+    peers[index] = found;
+    neutrino_destroy_task(&(SCExitArgs){.status = 0});
+}
+
+// checks that tasks pinned to different CPUs run in parallel, rather than taking turns on a single CPU
+int main() {
+    char buf[128];
+    uint32_t tids[SMPTEST_THREADS];
+
+    SCTopArgs top = {.cpus = top_cpus, .cpu_count = SMPTEST_THREADS};
+    neutrino_top(&top);
+    uint32_t threads = top.cpu_count;
+
+    if (threads < 2) {
+        neutrino_log(&(SCLogArgs){.msg = "CPU overlap: single CPU, skipped"});
+        return 0;
+    }
+
+    for (size_t i = 0; i < threads; i++) {
+        SCThreadArgs thread = {.entry = (uintptr_t)smptest_thread, .argument = i};
+        neutrino_thread_create(&thread);
+        tids[i] = thread.tid;
+
+        SCAffinityArgs affinity = {.pid = thread.tid, .allowed = NewCpuMask, .preferred = NewCpuMask};
+        cpu_mask_set(&affinity.allowed, i);
+        cpu_mask_set(&affinity.preferred, i);
+        neutrino_set_affinity(&affinity);
+    }
+
+    start = true;
+    for (size_t i = 0; i < threads; i++)
+        neutrino_thread_join(&(SCWaitArgs){.pid = tids[i]});
+
+    // every pair of threads must have been seen running at the same time at least once
+    size_t pairs = 0;
+    for (size_t i = 0; i < threads; i++)
+        for (size_t j = 0; j < threads; j++)
+            if (j != i && (peers[i] & (1u << j))) pairs++;
+
+    strf("CPU overlap: %u threads on %u CPUs, %u of %u pairs ran in parallel, %c", buf, threads, threads, pairs,
+         threads * (threads - 1), (pairs == threads * (threads - 1)) ? "correct" : "WRONG");
+    neutrino_log(&(SCLogArgs){.msg = buf});
+    return 0;
+}
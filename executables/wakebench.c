@@ -0,0 +1,103 @@
+#include <neutrino/syscall.h>
+#include <neutrino/cpumask.h>
+#include <_null.h>
+#include <string.h>
+#include <stdint.h>
+
+#define WAKEBENCH_ROUNDS    1000
+#define WAKEBENCH_SETTLE    200000      // cycles the waker lets pass, so that the waiter's CPU is idle when woken
+
+typedef enum __wakebench_role {
+    WAKEBENCH_WAKER,
+    WAKEBENCH_WAITER,
+    WAKEBENCH_ROLES
+} WakebenchRole;
+
+static TopCpu top_cpus[WAKEBENCH_ROLES];
+
+static volatile uint32_t round = 0;             // the futex, set to the round the waiter is woken for
+static volatile uint32_t waiting = 0;           // the round the waiter is about to wait for
+static volatile uint64_t woken_at = 0;
+
+static uint64_t total = 0, slowest = 0;
+static size_t blocked = 0;                      // rounds the waiter was really woken up from a blocked state
+
+static inline uint64_t rdtsc() {
+    uint32_t low, high;
+    asm volatile("rdtsc" : "=a"(low), "=d"(high));
+    return ((uint64_t)high << 32) | low;
+}
+
+// the waker changes the futex and wakes the waiter, blocked on another CPU which is idle in the meantime
+void wakebench_waker() {
+    for (uint32_t i = 0; i < WAKEBENCH_ROUNDS; i++) {
+        while (waiting != i + 1) asm volatile ("pause");
+
+        uint64_t settle = rdtsc();
+        while (rdtsc() - settle < WAKEBENCH_SETTLE) asm volatile ("pause");
+
+        woken_at = rdtsc();
+        round = i + 1;
+        neutrino_futex(&(SCFutexArgs){.op = FUTEX_WAKE, .address = &round, .value = 1});
+    }
+}
+
+// the waiter measures the cycles from the wake to its first instruction back in user mode
+void wakebench_waiter() {
+    for (uint32_t i = 0; i < WAKEBENCH_ROUNDS; i++) {
+        bool slept = false;
+        waiting = i + 1;
+
+        while (round == i) {
+            SCFutexArgs wait = {.op = FUTEX_WAIT, .address = &round, .value = i};
+            if (neutrino_futex(&wait) == SYSCALL_SUCCESS) slept = true;
+        }
+
+        uint64_t latency = rdtsc() - woken_at;
+        if (!slept) continue;       // the futex changed before the waiter blocked, nothing was measured
+
+        blocked++;
+        total += latency;
+        if (latency > slowest) slowest = latency;
+    }
+}
+
+void wakebench_thread(uintptr_t role) {
+    if (role == WAKEBENCH_WAKER) wakebench_waker();
+    else wakebench_waiter();
+
+    neutrino_destroy_task(&(SCExitArgs){.status = 0});
+}
+
+// times the handoff from a futex wake on a CPU to the woken task running on another, idle, CPU
+int main() {
+    char buf[128];
+    uint32_t tids[WAKEBENCH_ROLES];
+
+    SCTopArgs top = {.cpus = top_cpus, .cpu_count = WAKEBENCH_ROLES};
+    neutrino_top(&top);
+    if (top.cpu_count < WAKEBENCH_ROLES) {
+        neutrino_log(&(SCLogArgs){.msg = "wakebench cross-CPU wakeup: single CPU, skipped"});
+        return 0;
+    }
+
+    // the waiter is started first and pinned before the waker can wake it
+    for (int role = WAKEBENCH_ROLES - 1; role >= 0; role--) {
+        SCThreadArgs thread = {.entry = (uintptr_t)wakebench_thread, .argument = role};
+        neutrino_thread_create(&thread);
+        tids[role] = thread.tid;
+
+        SCAffinityArgs affinity = {.pid = thread.tid, .allowed = NewCpuMask, .preferred = NewCpuMask};
+        cpu_mask_set(&affinity.allowed, role);
+        cpu_mask_set(&affinity.preferred, role);
+        neutrino_set_affinity(&affinity);
+    }
+
+    for (size_t role = 0; role < WAKEBENCH_ROLES; role++)
+        neutrino_thread_join(&(SCWaitArgs){.pid = tids[role]});
+
+    strf("wakebench cross-CPU wakeup: %u cycles on average, slowest %u cycles, %u rounds measured", buf,
+         (blocked > 0) ? total / blocked : 0, slowest, blocked);
+    neutrino_log(&(SCLogArgs){.msg = buf});
+    return 0;
+}
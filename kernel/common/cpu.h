@@ -3,17 +3,30 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <size_t.h>
+#include <neutrino/macros.h>
 #include "tasks/task.h"
 
-#define MAX_CPU 64
+#define MAX_CPU CPU_MASK_BITS
 #define CPU_STACK_SIZE      0x8000
 #define CPU_STACK_BASE      0xfffff80000000000
 
+// base of the interrupt stack of a CPU. Stacks are separated by an unmapped guard page
+#define CpuStackBase(id)    (CPU_STACK_BASE + (uintptr_t)(id) * (CPU_STACK_SIZE + 0x1000))
+
 struct __tasks {
     Lock is_switching;
     Task* idle;
     Task* current;
-    Task* next;
+    Task* prev;         // the task switched out by the last cycle, handed over once the CPU left its stack
+    bool prev_moved;    // the previous task can't run on the CPU anymore, it's woken up on another one
+    Task* reaper;       // kernel task destroying the zombies of the CPU
+    TaskQueue zombies;  // terminated tasks waiting for the reaper
+    bool tickless;      // the CPU timer is in one-shot mode, since there's no other task to switch to
+    volatile uint32_t preempt_count;    // the current task can't be preempted while non-zero, see preempt_disable()
+
+    // set by other CPUs to make the CPU run the scheduler. Kept on its own cache line, which an idle CPU monitors
+    volatile bool need_resched aligned(64);
+    volatile bool polling;  // the CPU is idle, waiting for a write to need_resched rather than for an interrupt
 };
 
 typedef struct __cpu Cpu;
@@ -27,3 +40,4 @@ typedef struct __cpu Cpu;
 size_t get_cpu_count();
 Cpu* get_cpu(uint32_t id);
 Cpu* get_current_cpu();
+void cpu_kick(uint32_t id);
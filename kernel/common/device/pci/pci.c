@@ -5,10 +5,13 @@
 #include <_null.h>
 #include <linkedlist.h>
 #include "kernel/common/memory/memory.h"
+#include "kernel/common/memory/arena.h"
 #include "kernel/common/device/port.h"
 #include "kernel/common/kservice.h"
 
 static List* device_list = nullptr;
+static Arena pci_arena = NewArena;       // device descriptors, never released
+static Arena pci_scratch = NewArena;     // configuration headers, released after each device
 
 // === PRIVATE FUNCTIONS ========================
 
@@ -57,7 +60,7 @@ PCIConfigDataCommon* pci_read_full_config(uint8_t bus, uint8_t dev, uint8_t fun)
                                        (hdr.type == 0x1) ? sizeof(PCIConfigPCIBridge) : 
                                        sizeof(PCIConfigCardBusBridge));
     
-    PCIConfigDataCommon* res = (PCIConfigDataCommon*)kmalloc(hdr_size);
+    PCIConfigDataCommon* res = (PCIConfigDataCommon*)arena_alloc(&pci_scratch, hdr_size);
     for (size_t offset = 0; offset < hdr_size/2; offset++)
         *((uint16_t*)res+offset) = pci_read_config(bus, dev, fun, offset*2);
     
@@ -111,7 +114,7 @@ void pci_print_device(PCIDevice* d) {
 }
 
 PCIDevice* pci_add_device(PCILocation loc, PCIConfigDataCommon* common) {
-    PCIDevice* ndev = (PCIDevice*)kmalloc(sizeof(PCIDevice));
+    PCIDevice* ndev = (PCIDevice*)arena_alloc(&pci_arena, sizeof(PCIDevice));
     ndev->class = common->class_code;
     ndev->subclass = common->subclass;
     ndev->dev_info.device_id = common->device;
@@ -123,7 +126,7 @@ PCIDevice* pci_add_device(PCILocation loc, PCIConfigDataCommon* common) {
     if (common->header_type.type == 0x0 || common->header_type.type == 0x1) {
         PCIConfigGeneralDevice* h = (PCIConfigGeneralDevice*)common;
         ndev->bars_count = pci_get_bar_count(h->base_addr, h->common.header_type);
-        ndev->bars = (PCIBarInfo*)kmalloc(sizeof(PCIBarInfo) * ndev->bars_count);
+        ndev->bars = (PCIBarInfo*)arena_alloc(&pci_arena, sizeof(PCIBarInfo) * ndev->bars_count);
         
         for (size_t i = 0; i < ndev->bars_count; i++) {
             ndev->bars[i].type = h->base_addr[i].bar_type;
@@ -148,6 +151,7 @@ void pci_check_fun(uint8_t bus, uint8_t dev, uint8_t fun) {
 
 void pci_check_dev(uint8_t bus, uint8_t dev) {
     if (pci_get_vendor(bus, dev, 0) == INVALID_VENDOR) return;
+    ArenaRetain(pci_scratch);
     pci_check_fun(bus, dev, 0);
 
     pci_print_device(pci_add_device((PCILocation){bus, dev, 0}, pci_read_full_config(bus, dev, 0)));
@@ -216,5 +220,9 @@ PCIDevice* pci_get_device_by_vendor(uint16_t vendor_id, uint16_t device_id) {
 
 void init_pci() {
     pci_check_all_buses();
+
+    ks.dbg("PCI enumeration served %u allocations from %u arena chunks", 
+        pci_arena.allocations + pci_scratch.allocations, pci_arena.chunks + pci_scratch.chunks);
+    arena_destroy(&pci_scratch);
     ks.log("PCI devices enumeration complete");
 }
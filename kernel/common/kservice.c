@@ -1,12 +1,15 @@
 #include "kservice.h"
 #include "kernel/common/device/serial.h"
 #include "interrupts.h"
+#include "kernel/common/spinlock.h"
 #include <stdarg.h>
 #include <string.h>
 #include <stdint.h>
 #include <neutrino/lock.h>
 #include <neutrino/macros.h>
 
+struct KernelService ks;
+
 // Private functions declarations
 
 void kput(char* message, ...);
@@ -27,7 +30,7 @@ void init_kservice() {
     ks.warn = kwarn;
     ks.err = kerr;
     ks.fatal = kpanic;
-    ks.lock = NewLock;
+    ks.lock = NewNamedTicketLock("kservice");
 
     ks.log("Kernel services initialized.");
 }
@@ -55,8 +58,8 @@ void kput(char* message, ...) {
     ks._helper(vstrf(message, buf, args));
 }
 
-void unoptimized klog(char* message, ...) {
-    LockRetain(ks.lock); 
+void klog(char* message, ...) {
+    TicketRetainIrq(ks.lock);
     va_list args; va_start(args, message);
     char buf[2048] = {0};
     ks._helper("[LOG] ");
@@ -64,8 +67,8 @@ void unoptimized klog(char* message, ...) {
     ks._helper("\n");
 }
 
-void unoptimized kdbg(char* message, ...) {
-    LockRetain(ks.lock); 
+void kdbg(char* message, ...) {
+    TicketRetainIrq(ks.lock);
     va_list args; va_start(args, message);
     char buf[2048] = {0};
     ks._helper("[DEBUG] ");
@@ -73,8 +76,8 @@ void unoptimized kdbg(char* message, ...) {
     ks._helper("\n");
 }
 
-void unoptimized kwarn(char* message, ...) {
-    LockRetain(ks.lock); 
+void kwarn(char* message, ...) {
+    TicketRetainIrq(ks.lock);
     va_list args; va_start(args, message);
     char buf[2048] = {0};
     ks._helper("[WARN] ");
@@ -82,8 +85,8 @@ void unoptimized kwarn(char* message, ...) {
     ks._helper("\n");
 }
 
-void unoptimized kerr(char* message, ...) {
-    LockRetain(ks.lock); 
+void kerr(char* message, ...) {
+    TicketRetainIrq(ks.lock);
     va_list args; va_start(args, message);
     char buf[2048] = {0};
     ks._helper("[ERR] ");
@@ -91,9 +94,9 @@ void unoptimized kerr(char* message, ...) {
     ks._helper("\n");
 }
 
-void unoptimized kpanic(Fatal fatal_error, ...) {
+void kpanic(Fatal fatal_error, ...) {
     disable_interrupts();
-    lock(&ks.lock);
+    ticket_lock(&ks.lock);
     va_list args; va_start(args, fatal_error);
     char buf[2048] = {0}, cbuf[32] = {0};
     ltoa((uint64_t)fatal_error.code, 16, cbuf);
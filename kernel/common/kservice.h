@@ -35,7 +35,7 @@ struct KernelService {
 
     void (*_put) (char* message, ...);
     void (*_helper) (char* message);
-    Lock lock;
+    TicketLock lock;
 };
 
 enum KSERVICE_TYPE {
@@ -48,7 +48,7 @@ enum KSERVICE_TYPE {
 };
 
 //? Global KernelService
-struct KernelService ks;
+extern struct KernelService ks;
 
 void init_kservice();
 void set_kservice(enum KSERVICE_TYPE, void (*));
@@ -0,0 +1,76 @@
+#include "lockstat.h"
+#include "kservice.h"
+#include "kernel/common/memory/memory.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <size_t.h>
+#include <string.h>
+#include <neutrino/lock.h>
+
+// Lock statistics are only collected by kernels built with LOCKSTAT=1, the locks don't carry them otherwise
+
+// === PUBLIC FUNCTIONS =========================
+
+// *Get if the kernel collects lock statistics
+// @return true if built with LOCKSTAT=1, false otherwise
+bool lockstat_available() {
+#ifdef __lockstat
+    return true;
+#else
+    return false;
+#endif
+}
+
+// *Clear the statistics of every named lock. Counters updated meanwhile by a holder may survive the reset
+void lockstat_reset() {
+#ifdef __lockstat
+    for (LockStat* stat = lockstat_registry; stat != nullptr; stat = stat->next) {
+        stat->acquisitions = stat->contended = stat->spin_cycles = stat->max_spin = 0;
+        stat->holder = 0;
+    }
+#endif
+}
+
+// *Take a snapshot of the statistics of the named locks
+// @param entries the entries to fill
+// @param count the number of entries available
+// @param total set to the number of named locks, which may be more than the filled entries
+// @return the number of filled entries
+size_t lockstat_read(LockStatEntry* entries, size_t count, size_t* total) {
+    size_t filled = 0, found = 0;
+
+#ifdef __lockstat
+    for (LockStat* stat = lockstat_registry; stat != nullptr; stat = stat->next, found++) {
+        if (filled >= count) continue;
+
+        LockStatEntry* entry = &entries[filled++];
+        size_t length = Min(strlen(stat->name), LOCKSTAT_NAME_MAX - 1);
+        memory_copy((uint8_t*)stat->name, (uint8_t*)entry->name, length);
+        entry->name[length] = '\0';
+
+        entry->acquisitions = stat->acquisitions;
+        entry->contended = stat->contended;
+        entry->spin_cycles = stat->spin_cycles;
+        entry->max_spin = stat->max_spin;
+        entry->holder = stat->holder;
+    }
+#endif
+
+    if (total != nullptr) *total = found;
+    return filled;
+}
+
+// *Print the statistics of the named locks on the serial output, the most recently registered first
+void lockstat_dump() {
+#ifdef __lockstat
+    ks.log("Lock statistics:");
+
+    for (LockStat* stat = lockstat_registry; stat != nullptr; stat = stat->next) {
+        uint64_t average = (stat->contended != 0) ? stat->spin_cycles / stat->contended : 0;
+        ks.log("  %c: %u acquisitions, %u contended, %u cycles spinning (average %u, max %u), last holder 0x%x",
+               stat->name, stat->acquisitions, stat->contended, stat->spin_cycles, average, stat->max_spin, stat->holder);
+    }
+#else
+    ks.log("Lock statistics are not collected, the kernel must be built with LOCKSTAT=1");
+#endif
+}
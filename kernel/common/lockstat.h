@@ -0,0 +1,11 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <size_t.h>
+#include <neutrino/lock.h>
+#include <neutrino/lockstat.h>
+
+bool lockstat_available();
+void lockstat_reset();
+size_t lockstat_read(LockStatEntry* entries, size_t count, size_t* total);
+void lockstat_dump();
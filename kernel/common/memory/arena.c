@@ -0,0 +1,142 @@
+#include "arena.h"
+#include "memory.h"
+#include "kernel/common/cpu.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <size_t.h>
+#include <_null.h>
+#include <neutrino/macros.h>
+
+#ifdef __x86_64
+#include "kernel/x86_64/memory/paging.h"
+#else
+#error "Unsupported platform"
+#endif
+
+#define ARENA_HEADER_SIZE   AlignUp(sizeof(ArenaChunk), ARENA_ALIGNMENT)
+
+static Arena scratch_arenas[MAX_CPU];
+
+// === PRIVATE FUNCTIONS ========================
+
+// *Request a new page-backed chunk able to hold at least [size] bytes (header included)
+// @param size the minimum size of the chunk
+// @return the new chunk, or nullptr if no memory is available
+ArenaChunk* arena_new_chunk(size_t size) {
+    size = AlignUp(size, PAGE_SIZE);
+    ArenaChunk* chunk = (ArenaChunk*)memory_allocate_large(size / PAGE_SIZE);
+    if (chunk == nullptr) return nullptr;
+
+    chunk->next = nullptr;
+    chunk->pages = size / PAGE_SIZE;
+    chunk->capacity = size - ARENA_HEADER_SIZE;
+    chunk->used = 0;
+
+    return chunk;
+}
+
+// === PUBLIC FUNCTIONS =========================
+
+// *Initialize an empty arena. No memory is requested until the first allocation
+// @param arena the arena to initialize
+// @param chunk_size the default size of the chunks backing the arena
+void arena_init(Arena* arena, size_t chunk_size) {
+    *arena = NewArena;
+    arena->chunk_size = (chunk_size > 0 ? chunk_size : ARENA_CHUNK_SIZE);
+}
+
+// *Give every chunk of the [arena] back to the memory manager
+// @param arena the arena to destroy
+void arena_destroy(Arena* arena) {
+    ArenaChunk* chunk = arena->head;
+    while (chunk != nullptr) {
+        ArenaChunk* next = chunk->next;
+        memory_free_large((uintptr_t)chunk, chunk->pages);
+        chunk = next;
+    }
+
+    arena->head = arena->current = nullptr;
+}
+
+// *Bump-allocate [size] bytes from the [arena]. Memory is released only by a reset, a rewind or a destroy
+// @param arena the arena to allocate from
+// @param size the number of bytes to allocate
+// @return the pointer to the allocated memory, aligned to ARENA_ALIGNMENT
+void* arena_alloc(Arena* arena, size_t size) {
+    if (arena == nullptr || size == 0) return nullptr;
+    size = AlignUp(size, ARENA_ALIGNMENT);
+
+    // chunks after the current one are free, either retained by a reset or a rewind
+    ArenaChunk* chunk = arena->current, *last = nullptr;
+    while (chunk != nullptr && chunk->used + size > chunk->capacity) {
+        last = chunk;
+        if ((chunk = chunk->next) != nullptr) chunk->used = 0;
+    }
+
+    if (chunk == nullptr) {
+        chunk = arena_new_chunk(Max(arena->chunk_size, size + ARENA_HEADER_SIZE));
+        if (chunk == nullptr) return nullptr;
+        arena->chunks++;
+
+        if (last == nullptr) arena->head = chunk;
+        else last->next = chunk;
+    }
+
+    void* ptr = (void*)((uintptr_t)chunk + ARENA_HEADER_SIZE + chunk->used);
+    chunk->used += size;
+    arena->current = chunk;
+    arena->allocations++;
+
+    return ptr;
+}
+
+// *Bump-allocate [size] zeroed bytes from the [arena]
+// @param arena the arena to allocate from
+// @param size the number of bytes to allocate
+// @return the pointer to the allocated memory
+void* arena_calloc(Arena* arena, size_t size) {
+    void* ptr = arena_alloc(arena, size);
+    if (ptr != nullptr) memory_set((uint8_t*)ptr, 0, size);
+
+    return ptr;
+}
+
+// *Release every allocation of the [arena] at once, keeping its chunks for reuse
+// @param arena the arena to reset
+void arena_reset(Arena* arena) {
+    arena->current = arena->head;
+    if (arena->current != nullptr) arena->current->used = 0;
+}
+
+// *Save the current position of the [arena]
+// @param arena the arena to get the position from
+// @return the position to be given to arena_rewind()
+ArenaMark arena_mark(Arena* arena) {
+    return (ArenaMark) {
+        .chunk = arena->current,
+        .used = (arena->current != nullptr ? arena->current->used : 0)
+    };
+}
+
+// *Release every allocation done in the [arena] after [mark] was taken
+// @param arena the arena to rewind
+// @param mark the position returned by arena_mark()
+void arena_rewind(Arena* arena, ArenaMark mark) {
+    if (mark.chunk == nullptr) {
+        arena_reset(arena);
+        return;
+    }
+
+    arena->current = mark.chunk;
+    arena->current->used = mark.used;
+}
+
+// *Get the scratch arena of the current CPU. Since it's shared by every task running on the CPU,
+// *it must only be used where the caller can't be preempted, and released with ArenaRetain(*arena_scratch())
+// @return the scratch arena of the current CPU
+Arena* arena_scratch() {
+    Arena* scratch = &scratch_arenas[get_current_cpu()->id];
+    if (scratch->chunk_size == 0) arena_init(scratch, ARENA_CHUNK_SIZE);
+
+    return scratch;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "memory.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <size_t.h>
+#include <neutrino/macros.h>
+#include <_null.h>
+
+#define ARENA_CHUNK_SIZE    0x4000
+#define ARENA_ALIGNMENT     16
+
+typedef struct __arena_chunk {
+    struct __arena_chunk* next;
+    size_t pages;               // backing pages of the chunk (header included)
+    size_t capacity;            // usable bytes after the header
+    size_t used;                // bytes already handed out
+} ArenaChunk;
+
+typedef struct __arena {
+    ArenaChunk* head;           // first chunk, kept across resets
+    ArenaChunk* current;        // chunk allocations are bumped from
+    size_t chunk_size;
+
+    size_t allocations;         // allocations served since creation
+    size_t chunks;              // chunks requested to the memory manager
+} Arena;
+
+typedef struct __arena_mark {
+    ArenaChunk* chunk;
+    size_t used;
+} ArenaMark;
+
+typedef struct __arena_scope {
+    Arena* arena;
+    ArenaMark mark;
+} ArenaScope;
+
+#define NewArena    (Arena){nullptr, nullptr, ARENA_CHUNK_SIZE, 0, 0}
+
+void arena_init(Arena* arena, size_t chunk_size);
+void arena_destroy(Arena* arena);
+
+void* arena_alloc(Arena* arena, size_t size);
+void* arena_calloc(Arena* arena, size_t size);
+void arena_reset(Arena* arena);
+
+ArenaMark arena_mark(Arena* arena);
+void arena_rewind(Arena* arena, ArenaMark mark);
+
+Arena* arena_scratch();
+
+static inline ArenaScope arena_scope_begin(Arena* arena) {
+    return (ArenaScope){arena, arena_mark(arena)};
+}
+
+static inline void arena_scope_release(ArenaScope* scope) {
+    if (scope != nullptr && scope->arena != nullptr) {
+        arena_rewind(scope->arena, scope->mark);
+        scope->arena = nullptr;
+    }
+}
+
+#define _ArenaRetain(ret, a)    \
+    ArenaScope ret cleanup(arena_scope_release) = arena_scope_begin(a);
+
+// *Rewind the arena [a] to its current position when the enclosing scope ends
+#define ArenaRetain(a)    \
+    _ArenaRetain(Concat(arena_scope, __COUNTER__), &a)
@@ -8,7 +8,7 @@
 // @param source the source memory pointer
 // @param dest the destination memory pointer
 // @param nbytes the number of bytes to copy
-void unoptimized memory_copy(uint8_t *source, uint8_t *dest, int nbytes) {
+void memory_copy(uint8_t *source, uint8_t *dest, int nbytes) {
     int i;
     for (i = 0; i < nbytes; i++) {
         *(dest + i) = *(source + i);
@@ -19,7 +19,7 @@ void unoptimized memory_copy(uint8_t *source, uint8_t *dest, int nbytes) {
 // @param dest the memory location to set bytes
 // @param val the value to set the bytes to
 // @param len the number of bytes to set
-void unoptimized memory_set(uint8_t *dest, uint8_t val, uint32_t len) {
+void memory_set(uint8_t *dest, uint8_t val, uint32_t len) {
     uint8_t *temp = (uint8_t *)dest;
     for ( ; len != 0; len--) *temp++ = val;
 }
@@ -29,7 +29,7 @@ void unoptimized memory_set(uint8_t *dest, uint8_t val, uint32_t len) {
 #include "kernel/x86_64/arch.h"
 
 VirtualMapping memory_allocate(size_t size) {
-    uintptr_t vaddr = vmm_allocate_memory(0, (size / PAGE_SIZE)+1, PageKernelWrite);
+    uintptr_t vaddr = vmm_allocate_memory(0, AlignUp(size, PAGE_SIZE) / PAGE_SIZE, PageKernelWrite);
     
     memory_set((uint8_t*)vaddr, 0, size);
 
@@ -43,7 +43,21 @@ VirtualMapping memory_allocate(size_t size) {
 }
 
 void memory_free(VirtualMapping mapping) {
-    vmm_free_memory(0, mapping.virtual_base, (mapping.physical.size / PAGE_SIZE)+1);
+    vmm_free_memory(0, mapping.virtual_base, AlignUp(mapping.physical.size, PAGE_SIZE) / PAGE_SIZE);
+}
+
+// *Allocate [blocks] pages of kernel memory which are virtually, but not physically, contiguous
+// @param blocks the number of pages to allocate
+// @return the virtual address of the allocated memory, or nullptr on failure
+uintptr_t memory_allocate_large(size_t blocks) {
+    return vmm_allocate_large(blocks);
+}
+
+// *Free memory allocated with memory_allocate_large(), giving its pages back to the physical memory manager
+// @param addr the virtual address of the memory
+// @param blocks the number of pages of the memory
+void memory_free_large(uintptr_t addr, size_t blocks) {
+    vmm_free_large(addr, blocks);
 }
 
 void memory_map(uintptr_t phys, uint32_t virt, size_t size) {
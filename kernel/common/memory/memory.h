@@ -25,5 +25,7 @@ void memory_set(uint8_t *dest, uint8_t val, uint32_t len);
 
 VirtualMapping memory_allocate(size_t size);
 void memory_free(VirtualMapping mapping);
+uintptr_t memory_allocate_large(size_t blocks);
+void memory_free_large(uintptr_t addr, size_t blocks);
 void memory_map(uintptr_t phys, uint32_t virt, size_t size);
 bool memory_unmap(uint32_t virt, size_t size);
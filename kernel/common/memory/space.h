@@ -18,7 +18,9 @@ typedef struct __space Space;
 
 Space* NewSpace();
 void DestroySpace(Space* space);
+Space* space_retain(Space* space);
 
 void space_switch(Space* space);
 void space_map(Space* space, uintptr_t phys_addr, uintptr_t virt_addr, size_t size, MappingFlags flags);
 void space_unmap(Space* space, uintptr_t virt_addr);
+bool space_read_user_u32(Space* space, uintptr_t virt_addr, uint32_t* value);
@@ -10,6 +10,7 @@
 #include "fs/fs.h"
 #include "fs/initrd.h"
 #include "tasks/loader.h"
+#include "memory/arena.h"
 #include <libs/elf/elf.h>
 #include <liballoc.h>
 #include <neutrino-gfx/tga.h>
@@ -59,12 +60,13 @@ void display() {
 void initrd_explorer() {
     int i = 0;
     struct __dirent* node = 0;
+    Arena files = NewArena;
 
     while ((node = fs_readdir(root, i)) != nullptr) {
         FsNode* fsnode = fs_finddir(root, node->name);
 
         if ((fsnode->flags & 0x7) == FS_FILE) {
-            char* buf = (char*)kmalloc(fsnode->length);
+            char* buf = (char*)arena_alloc(&files, fsnode->length);
             fs_read(fsnode, 0, fsnode->length, (uint8_t*)buf);
 
             // elf check
@@ -72,10 +74,12 @@ void initrd_explorer() {
             if (elf_check(header)) 
                 load_binary((const uintptr_t)header, fsnode->name, true);
             
-            kfree(buf);
+            arena_reset(&files);
         }
         i++;
     }
+
+    arena_destroy(&files);
 }
 
 // === PUBLIC FUNCTIONS =========================
@@ -86,8 +90,11 @@ void neutrino_main() {
 
     init_pci();
     
-    // Task* initrd_task = NewTask("initrd_explorer", false);
-    // sched_start(initrd_task, (uintptr_t)initrd_explorer);
+#ifdef __autorun
+    // kernels built with AUTORUN=1 start every executable of the initrd, see utils/bench.sh
+    Task* initrd_task = NewTask("initrd_explorer", false);
+    sched_start(initrd_task, (uintptr_t)initrd_explorer);
+#endif
 
     Task* display_task = NewTask("display", false);
     sched_start(display_task, (uintptr_t)display);
@@ -0,0 +1,160 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <neutrino/lock.h>
+#include <neutrino/macros.h>
+#include "tasks/scheduler.h"
+
+#ifdef __x86_64
+#include "kernel/x86_64/interrupts.h"
+#else
+#error "Unsupported platform"
+#endif
+
+// Spinlocks taken both by tasks and by interrupt handlers must disable interrupts while held: an interrupt
+// handler spinning on a lock held by the task it interrupted would never return.
+// Spinlocks only taken by tasks can be held with interrupts enabled, disabling the preemption instead, so that
+// the other CPUs never spin on a lock whose holder was switched out
+
+// --- Interrupt-safe locks ---------------------
+
+// *Disable the interrupts, then lock a spinlock
+// @param l the lock to be locked
+// @return the interrupt state, given to unlock_irqrestore()
+static inline bool lock_irqsave(Lock* l) {
+    bool enabled = interrupts_save();
+    lock(l);
+    return enabled;
+}
+
+// *Unlock a spinlock, then restore the interrupts
+// @param l the lock to be unlocked
+// @param enabled the interrupt state returned by lock_irqsave()
+static inline void unlock_irqrestore(Lock* l, bool enabled) {
+    unlock(l);
+    interrupts_restore(enabled);
+}
+
+// *Disable the interrupts, then lock a ticket lock
+// @param l the lock to be locked
+// @return the interrupt state, given to ticket_unlock_irqrestore()
+static inline bool ticket_lock_irqsave(TicketLock* l) {
+    bool enabled = interrupts_save();
+    ticket_lock(l);
+    return enabled;
+}
+
+// *Unlock a ticket lock, then restore the interrupts
+// @param l the lock to be unlocked
+// @param enabled the interrupt state returned by ticket_lock_irqsave()
+static inline void ticket_unlock_irqrestore(TicketLock* l, bool enabled) {
+    ticket_unlock(l);
+    interrupts_restore(enabled);
+}
+
+// *Disable the interrupts, then lock an MCS lock
+// @param l the lock to be locked
+// @param node the queue node of the caller
+// @return the interrupt state, given to mcs_unlock_irqrestore()
+static inline bool mcs_lock_irqsave(McsLock* l, McsNode* node) {
+    bool enabled = interrupts_save();
+    mcs_lock(l, node);
+    return enabled;
+}
+
+// *Unlock an MCS lock, then restore the interrupts
+// @param l the lock to be unlocked
+// @param node the queue node given to mcs_lock_irqsave()
+// @param enabled the interrupt state returned by mcs_lock_irqsave()
+static inline void mcs_unlock_irqrestore(McsLock* l, McsNode* node, bool enabled) {
+    mcs_unlock(l, node);
+    interrupts_restore(enabled);
+}
+
+// --- Preemption-safe locks --------------------
+
+// *Disable the preemption of the current task, then lock a spinlock. The lock must not be held across a block
+// @param l the lock to be locked
+static inline void lock_preempt(Lock* l) {
+    preempt_disable();
+    lock(l);
+}
+
+// *Unlock a spinlock, then enable the preemption again
+// @param l the lock to be unlocked
+static inline void unlock_preempt(Lock* l) {
+    unlock(l);
+    preempt_enable();
+}
+
+// *Disable the preemption of the current task, then lock a ticket lock. The lock must not be held across a block
+// @param l the lock to be locked
+static inline void ticket_lock_preempt(TicketLock* l) {
+    preempt_disable();
+    ticket_lock(l);
+}
+
+// *Unlock a ticket lock, then enable the preemption again
+// @param l the lock to be unlocked
+static inline void ticket_unlock_preempt(TicketLock* l) {
+    ticket_unlock(l);
+    preempt_enable();
+}
+
+// --- Scoped locks -----------------------------
+
+typedef struct __ticket_irq_guard {
+    TicketLock* lock;
+    bool enabled;
+} TicketIrqGuard;
+
+typedef struct __mcs_irq_guard {
+    McsLock* lock;
+    McsNode node;
+    bool enabled;
+} McsIrqGuard;
+
+static inline void ticket_irq_retainer_release(TicketIrqGuard* guard) {
+    if (guard->lock != nullptr) {
+        ticket_unlock_irqrestore(guard->lock, guard->enabled);
+        guard->lock = nullptr;
+    }
+}
+
+static inline void mcs_irq_retainer_release(McsIrqGuard* guard) {
+    if (guard->lock != nullptr) {
+        mcs_unlock_irqrestore(guard->lock, &guard->node, guard->enabled);
+        guard->lock = nullptr;
+    }
+}
+
+static inline void preempt_retainer_release(Lock** l) {
+    if (l != nullptr && *l != nullptr) {
+        unlock_preempt(*l);
+        *l = nullptr;
+    }
+}
+
+#define _TicketRetainIrq(ret, l)    \
+    TicketIrqGuard ret cleanup(ticket_irq_retainer_release) = {.lock = l};    \
+    ret.enabled = ticket_lock_irqsave(ret.lock);
+
+// *Lock the ticket lock [l] with interrupts disabled until the enclosing scope ends
+#define TicketRetainIrq(l)    \
+    _TicketRetainIrq(Concat(ticket_irq_retainer, __COUNTER__), &l)
+
+#define _McsRetainIrq(ret, l)    \
+    McsIrqGuard ret cleanup(mcs_irq_retainer_release) = {.lock = l};    \
+    ret.enabled = mcs_lock_irqsave(ret.lock, &ret.node);
+
+// *Lock the MCS lock [l] with interrupts disabled until the enclosing scope ends
+#define McsRetainIrq(l)    \
+    _McsRetainIrq(Concat(mcs_irq_retainer, __COUNTER__), &l)
+
+#define _LockRetainPreempt(ret, l)    \
+    Lock* ret cleanup(preempt_retainer_release) = l;    \
+    lock_preempt(ret);
+
+// *Lock the spinlock [l] with preemption disabled until the enclosing scope ends
+#define LockRetainPreempt(l)    \
+    _LockRetainPreempt(Concat(preempt_retainer, __COUNTER__), &l)
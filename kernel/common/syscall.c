@@ -5,12 +5,29 @@
 #include "tasks/channel.h"
 #include "memory/space.h"
 #include "tasks/scheduler.h"
+#include "tasks/schedstat.h"
+#include "lockstat.h"
+#include "tasks/reaper.h"
+#include "tasks/cputime.h"
+#include "tasks/futex.h"
+#include "tasks/pid.h"
 #include <neutrino/syscall.h>
 #include <ipc/ipc.h>
 #include <stdint.h>
 
 // === PRIVATE FUNCTIONS ========================
 
+// *Check that the calling task can act on the task of a pid. User tasks can't act on kernel tasks.
+// *Must be called between pid_read_begin() and pid_read_end()
+// @param task the task found by pid_lookup()
+// @return SYSCALL_SUCCESS if the caller can act on the task; SYSCALL_INVALID if no task has the pid;
+// @return SYSCALL_UNAUTHORIZED if a user task targets a kernel task
+SyscallResult syscall_check_target(Task* task) {
+    if (task == nullptr) return SYSCALL_INVALID;
+    if (!task->user && get_current_task()->user) return SYSCALL_UNAUTHORIZED;
+    return SYSCALL_SUCCESS;
+}
+
 SyscallResult sys_log(SCLogArgs* args) {
     if (args->msg == nullptr) return SYSCALL_INVALID;
 
@@ -18,8 +35,8 @@ SyscallResult sys_log(SCLogArgs* args) {
     return SYSCALL_SUCCESS;
 }
 
-SyscallResult sys_destroy_task(uintptr_t* args) {
-    sched_terminate();
+SyscallResult sys_destroy_task(SCExitArgs* args) {
+    sched_exit((args != nullptr) ? args->status : QUIT_SUCCESS);
     return SYSCALL_FAILURE; // return failure on sched_terminate return 
 }
 
@@ -76,7 +93,7 @@ SyscallResult sys_ipc(SCIpcArgs* args) {
         if (!recv) return SYSCALL_FAILURE;
 
         if (args->type == IPC_RECEIVE) {
-            ChannelReceiveResult res = channel_receive(recv, &pack);
+            ChannelReceiveResult res = channel_receive_wait(recv, &pack);
             if (pack && res == CHANNEL_RECEIVE_SUCCESS) {
                 memory_copy((uint8_t*)pack->buffer, (uint8_t*)args->payload, pack->size);
                 args->size = pack->size;
@@ -114,6 +131,206 @@ SyscallResult sys_ipc(SCIpcArgs* args) {
     return SYSCALL_FAILURE;
 }
 
+SyscallResult sys_set_priority(SCPriorityArgs* args) {
+    bool enabled = pid_read_begin();
+    Task* task = pid_lookup(args->pid);
+
+    SyscallResult result = syscall_check_target(task);
+    if (result == SYSCALL_SUCCESS && !sched_set_priority(task, args->priority)) result = SYSCALL_INVALID;
+
+    pid_read_end(enabled);
+    return result;
+}
+
+SyscallResult sys_sched_stats(SCSchedStatsArgs* args) {
+    // the statistics are shared by every task, user tasks can only read them
+    if (args->command != SCHED_STATS_READ && get_current_task()->user) return SYSCALL_UNAUTHORIZED;
+
+    switch (args->command) {
+        case SCHED_STATS_ENABLE: schedstat_enable(true); break;
+        case SCHED_STATS_DISABLE: schedstat_enable(false); break;
+        case SCHED_STATS_RESET: schedstat_reset(); break;
+        case SCHED_STATS_DUMP: schedstat_dump(); break;
+
+        case SCHED_STATS_READ: {
+            SchedCpuStats* cpu = schedstat_of(args->cpu_id);
+            if (cpu == nullptr) return SYSCALL_INVALID;
+
+            args->task = get_current_task()->stats.total;
+            args->cpu = *cpu;
+            break;
+        }
+
+        default: return SYSCALL_INVALID;
+    }
+
+    return SYSCALL_SUCCESS;
+}
+
+SyscallResult sys_get_affinity(SCAffinityArgs* args) {
+    bool enabled = pid_read_begin();
+    Task* task = pid_lookup(args->pid);
+
+    SyscallResult result = syscall_check_target(task);
+    if (result == SYSCALL_SUCCESS) {
+        args->allowed = task->cpu_affinity.allowed;
+        args->preferred = task->cpu_affinity.preferred;
+    }
+
+    pid_read_end(enabled);
+    return result;
+}
+
+SyscallResult sys_set_affinity(SCAffinityArgs* args) {
+    bool enabled = pid_read_begin();
+    Task* task = pid_lookup(args->pid);
+
+    SyscallResult result = syscall_check_target(task);
+    if (result == SYSCALL_SUCCESS && !sched_set_affinity(task, args->allowed, args->preferred)) result = SYSCALL_INVALID;
+    pid_read_end(enabled);
+
+    // the calling task leaves the current CPU at once if it's no longer allowed, other tasks on their next cycle
+    Task* current = get_current_task();
+    if (result == SYSCALL_SUCCESS && task == current && !cpu_mask_test(&current->cpu_affinity.allowed, get_current_cpu()->id))
+        sched_yield();
+    return result;
+}
+
+SyscallResult sys_wait(SCWaitArgs* args) {
+    switch (reaper_wait(get_current_task()->pid, args->pid, &args->status)) {
+        case REAPER_WAIT_SUCCESS: return SYSCALL_SUCCESS;
+        case REAPER_WAIT_NOT_CHILD: return SYSCALL_UNAUTHORIZED;
+        default: return SYSCALL_INVALID;
+    }
+}
+
+SyscallResult sys_thread_create(SCThreadArgs* args) {
+    if (args->entry == nullptr || args->tls >= CONTEXT_TLS_END) return SYSCALL_INVALID;
+
+    Task* thread = NewThread(get_current_task());
+    if (thread == nullptr) return SYSCALL_FAILURE;
+
+    context_set_tls(thread->context, args->tls);
+    args->tid = thread->pid;
+    sched_start_thread(thread, args->entry, args->argument);
+
+    return SYSCALL_SUCCESS;
+}
+
+SyscallResult sys_thread_join(SCWaitArgs* args) {
+    return sys_wait(args);
+}
+
+SyscallResult sys_yield(uintptr_t* args) {
+    sched_yield();
+    return SYSCALL_SUCCESS;
+}
+
+SyscallResult sys_sleep(SCSleepArgs* args) {
+    if (args->ns == 0) return SYSCALL_INVALID;
+
+    sched_sleep(args->ns);
+    return SYSCALL_SUCCESS;
+}
+
+SyscallResult sys_set_deadline(SCDeadlineArgs* args) {
+    Task* task = get_current_task();
+    if (args->runtime != 0 && (args->period == 0 || args->runtime > args->deadline || args->deadline > args->period))
+        return SYSCALL_INVALID;
+
+    uint64_t runtime = arch_ns_to_cycles(args->runtime);
+    if (!sched_set_deadline(task, runtime, arch_ns_to_cycles(args->deadline), arch_ns_to_cycles(args->period)))
+        return SYSCALL_FAILURE;
+
+    // move to the CPU the task was admitted on at once
+    if (runtime != 0 && task->dl.cpu_id != get_current_cpu()->id) sched_yield();
+    return SYSCALL_SUCCESS;
+}
+
+SyscallResult sys_get_deadline(SCDeadlineArgs* args) {
+    Task* task = get_current_task();
+    bool deadline = (task->sched_class == SCHED_CLASS_DEADLINE);
+
+    *args = (SCDeadlineArgs){
+        .runtime = deadline ? arch_cycles_to_ns(task->dl.runtime) : 0,
+        .deadline = deadline ? arch_cycles_to_ns(task->dl.deadline) : 0,
+        .period = deadline ? arch_cycles_to_ns(task->dl.period) : 0,
+        .misses = task->dl.misses
+    };
+
+    return SYSCALL_SUCCESS;
+}
+
+SyscallResult sys_top(SCTopArgs* args) {
+    if ((args->tasks == nullptr && args->task_count > 0) || (args->cpus == nullptr && args->cpu_count > 0))
+        return SYSCALL_INVALID;
+
+    size_t total = 0;
+    args->task_count = cputime_top(args->tasks, args->task_count, &total);
+    args->total_tasks = total;
+
+    uint32_t cpus = 0;
+    while (cpus < args->cpu_count && cputime_top_cpu(cpus, &args->cpus[cpus])) cpus++;
+    args->cpu_count = cpus;
+
+    return SYSCALL_SUCCESS;
+}
+
+SyscallResult sys_task_list(SCTaskListArgs* args) {
+    if (args->tasks == nullptr) return SYSCALL_INVALID;
+
+    args->count = task_list(args->from, args->tasks, args->count);
+    args->next = (args->count > 0) ? args->tasks[args->count - 1].pid + 1 : args->from;
+    return SYSCALL_SUCCESS;
+}
+
+SyscallResult sys_task_info(SCTaskInfoArgs* args) {
+    if (!task_info(args->pid, &args->info)) return SYSCALL_INVALID;
+    return SYSCALL_SUCCESS;
+}
+
+SyscallResult sys_lock_stats(SCLockStatsArgs* args) {
+    if (!lockstat_available()) return SYSCALL_FAILURE;
+
+    switch (args->command) {
+        case LOCK_STATS_RESET: lockstat_reset(); break;
+        case LOCK_STATS_DUMP: lockstat_dump(); break;
+
+        case LOCK_STATS_READ: {
+            if (args->entries == nullptr) return SYSCALL_INVALID;
+
+            size_t total = 0;
+            args->count = lockstat_read(args->entries, args->count, &total);
+            args->total = total;
+            break;
+        }
+
+        default: return SYSCALL_INVALID;
+    }
+
+    return SYSCALL_SUCCESS;
+}
+
+SyscallResult sys_futex(SCFutexArgs* args) {
+    uintptr_t address = (uintptr_t)args->address;
+    if (address == 0 || (address & 0b11) != 0 || address >= FUTEX_USER_END) return SYSCALL_INVALID;
+
+    switch (args->op) {
+        case FUTEX_WAIT:
+            switch (futex_wait(args->address, args->value)) {
+                case FUTEX_WAIT_WOKEN: return SYSCALL_SUCCESS;
+                case FUTEX_WAIT_CHANGED: return SYSCALL_FAILURE;
+                default: return SYSCALL_INVALID;
+            }
+
+        case FUTEX_WAKE:
+            args->woken = futex_wake(args->address, args->value);
+            return SYSCALL_SUCCESS;
+
+        default: return SYSCALL_INVALID;
+    }
+}
+
 // === PUBLIC FUNCTIONS =========================
 
 typedef SyscallResult SyscallFn();
@@ -124,7 +341,23 @@ SyscallFn* syscalls[NEUTRINO_SYSCALL_COUNT] = {
     [NEUTRINO_NOW] = sys_now,
     [NEUTRINO_ALLOC] = sys_alloc,
     [NEUTRINO_FREE] = sys_free,
-    [NEUTRINO_IPC] = sys_ipc
+    [NEUTRINO_IPC] = sys_ipc,
+    [NEUTRINO_SET_PRIORITY] = sys_set_priority,
+    [NEUTRINO_SCHED_STATS] = sys_sched_stats,
+    [NEUTRINO_GET_AFFINITY] = sys_get_affinity,
+    [NEUTRINO_SET_AFFINITY] = sys_set_affinity,
+    [NEUTRINO_WAIT] = sys_wait,
+    [NEUTRINO_THREAD_CREATE] = sys_thread_create,
+    [NEUTRINO_THREAD_JOIN] = sys_thread_join,
+    [NEUTRINO_YIELD] = sys_yield,
+    [NEUTRINO_SLEEP] = sys_sleep,
+    [NEUTRINO_SET_DEADLINE] = sys_set_deadline,
+    [NEUTRINO_GET_DEADLINE] = sys_get_deadline,
+    [NEUTRINO_TOP] = sys_top,
+    [NEUTRINO_TASK_LIST] = sys_task_list,
+    [NEUTRINO_TASK_INFO] = sys_task_info,
+    [NEUTRINO_LOCK_STATS] = sys_lock_stats,
+    [NEUTRINO_FUTEX] = sys_futex
 };
 
 SyscallResult syscall_execute(NeutrinoSyscall syscall_id, uintptr_t* args) {
@@ -1,52 +1,58 @@
 #include "channel.h"
+#include "waitqueue.h"
+#include "rcu.h"
 #include <libs/ringbuf.h>
 #include <libs/ipc/ipc.h>
 #include <string.h>
 #include <liballoc.h>
 #include <stdbool.h>
 #include <_null.h>
-#include <linkedlist.h>
 
-static Lock agent_channel_lock = NewLock;
-static List* agent_channel_map = nullptr;
+// the registry is read without locking, under RCU. The lock only serializes the writers
+static Lock agent_channel_lock = NewNamedLock("agent channel");
+static ChannelAgentData* agent_channel_map = nullptr;
 
 // === PRIVATE FUNCTIONS ========================
 
+// *Remove a channel from the registry, freeing its entry once no reader can see it anymore
+// @param channel the channel to remove
+// @return true if the channel was registered, false otherwise
 bool channel_agent_remove(Channel* channel) {
-    LockRetain(agent_channel_lock);
-    List* p = agent_channel_map;
-    size_t i = 0;
-
-    while (p != nullptr) {
-        ChannelAgentData* data = list_get_value(p);
-        
-        if (data->channel == channel) {
-            agent_channel_map = list_delete_at(agent_channel_map, i);
-            return true;
+    ChannelAgentData* removed = nullptr;
+
+    LockOperation(agent_channel_lock, {
+        for (ChannelAgentData** p = &agent_channel_map; *p != nullptr; p = &(*p)->next) {
+            if ((*p)->channel == channel) {
+                removed = *p;
+                RcuAssign(*p, removed->next);
+                break;
+            }
         }
+    });
 
-        p = p->next;
-        i++;
-    }
+    if (removed == nullptr) return false;
 
-    return false;
+    rcu_synchronize();
+    kfree(removed);
+    return true;
 }
 
+// *Check if a channel is registered. Inside a read section, the channel can't be destroyed until it ends
+// @param channel the channel
+// @return true if the channel is registered, false otherwise
 bool channel_exists(Channel* channel) {
-    List* p = agent_channel_map;
-    size_t i = 0;
-
-    while (p != nullptr) {
-        ChannelAgentData* data = list_get_value(p);
-        
-        if (data->channel == channel) 
-            return true;
+    bool found = false;
+    rcu_read_lock();
 
-        p = p->next;
-        i++;
+    for (ChannelAgentData* p = RcuDereference(agent_channel_map); p != nullptr; p = RcuDereference(p->next)) {
+        if (p->channel == channel) {
+            found = true;
+            break;
+        }
     }
 
-    return false;
+    rcu_read_unlock();
+    return found;
 }
  
 // === PUBLIC FUNCTIONS =========================
@@ -57,70 +63,105 @@ Channel* NewChannel(ChannelFlag flags, const char* agent_name) {
     channel->flags = flags;
     channel->ring_lock = NewLock;
     channel->ring = rb_init(channel->_buffer, CHANNEL_BUFFER_SIZE);
+    channel->receivers = (WaitQueue*)kmalloc(sizeof(WaitQueue));
+    *channel->receivers = NewWaitQueue;
+    channel->refs = 1;
     agent_init(&channel->agent, agent_name);
 
-    LockRetain(agent_channel_lock);
     ChannelAgentData* data = (ChannelAgentData*)kmalloc(sizeof(ChannelAgentData));
     data->agent = &channel->agent;
     data->channel = channel;
-    agent_channel_map = list_append(agent_channel_map, data);
+
+    // the entry is initialized before readers can reach it
+    LockOperation(agent_channel_lock, {
+        data->next = agent_channel_map;
+        RcuAssign(agent_channel_map, data);
+    });
 
     return channel;
 }
 
+// *Release a reference to a channel, destroying it if it was the last one
+// @param channel the channel to release
 void DestroyChannel(Channel* channel) {
-    rb_free(channel->ring);
+    if (__atomic_sub_fetch(&channel->refs, 1, __ATOMIC_ACQ_REL) > 0) return;
+
+    // transmits to the channel may be running until it's unregistered
     channel_agent_remove(channel);
+    rb_free(channel->ring);
     kfree(channel->_buffer);
+    kfree(channel->receivers);
     kfree(channel);
 }
 
-Channel* channel_find_by_agent_id(AgentID id) {
-    List* p = agent_channel_map;
-    size_t i = 0;
+// *Take a new reference to a channel, shared by the threads of a process
+// @param channel the channel to share
+// @return the same channel
+Channel* channel_retain(Channel* channel) {
+    __atomic_add_fetch(&channel->refs, 1, __ATOMIC_ACQ_REL);
+    return channel;
+}
 
-    while (p != nullptr) {
-        ChannelAgentData* data = list_get_value(p);
-        
-        if (data->agent->id == id) 
-            return data->channel;
+Channel* channel_find_by_agent_id(AgentID id) {
+    Channel* channel = nullptr;
+    rcu_read_lock();
 
-        p = p->next;
-        i++;
+    for (ChannelAgentData* p = RcuDereference(agent_channel_map); p != nullptr; p = RcuDereference(p->next)) {
+        if (p->agent->id == id) {
+            channel = p->channel;
+            break;
+        }
     }
 
-    return nullptr;
+    rcu_read_unlock();
+    return channel;
 }
 
 Channel* channel_find_by_agent_name(const char* name) {
-    List* p = agent_channel_map;
-    size_t i = 0;
-
-    while (p != nullptr) {
-        ChannelAgentData* data = list_get_value(p);
-        
-        if (strcmp(data->agent->name, name)) 
-            return data->channel;
+    Channel* channel = nullptr;
+    rcu_read_lock();
 
-        p = p->next;
-        i++;
+    for (ChannelAgentData* p = RcuDereference(agent_channel_map); p != nullptr; p = RcuDereference(p->next)) {
+        if (strcmp(p->agent->name, name)) {
+            channel = p->channel;
+            break;
+        }
     }
 
-    return nullptr;
+    rcu_read_unlock();
+    return channel;
 }
 
+// *Transmit a package to a channel. The recipient is looked up and used in the same read section, so that
+// *it can't be destroyed meanwhile
+// @param self the sending channel
+// @param dest the receiving channel
+// @param msg the package
+// @return CHANNEL_TRANSMIT_SUCCESS on success, or the reason the package can't be transmitted
 ChannelTransmitResult channel_transmit(Channel* self, Channel* dest, Package* msg) {
-    if (!(self && channel_exists(self))) return CHANNEL_TRANSMIT_BAD_SENDER;
-    if (!(self->flags & CHANNEL_CAN_SEND)) return CHANNEL_TRANSMIT_UNAUTHORIZED_SENDER;
-    if (!(dest && channel_exists(dest))) return CHANNEL_TRANSMIT_BAD_RECIPIENT;
-    if (!(dest->flags & CHANNEL_CAN_RECEIVE)) return CHANNEL_TRANSMIT_UNAUTHORIZED_RECIPIENT;
-    if (!msg) return CHANNEL_TRANSMIT_BAD_PACKAGE;
+    ChannelTransmitResult result = CHANNEL_TRANSMIT_SUCCESS;
+    rcu_read_lock();
+
+    if (!(self && channel_exists(self))) result = CHANNEL_TRANSMIT_BAD_SENDER;
+    else if (!(self->flags & CHANNEL_CAN_SEND)) result = CHANNEL_TRANSMIT_UNAUTHORIZED_SENDER;
+    else if (!(dest && channel_exists(dest))) result = CHANNEL_TRANSMIT_BAD_RECIPIENT;
+    else if (!(dest->flags & CHANNEL_CAN_RECEIVE)) result = CHANNEL_TRANSMIT_UNAUTHORIZED_RECIPIENT;
+    else if (!msg) result = CHANNEL_TRANSMIT_BAD_PACKAGE;
+
+    if (result == CHANNEL_TRANSMIT_SUCCESS) {
+        lock(&dest->ring_lock);
+        if (rb_is_full(dest->ring)) {
+            result = CHANNEL_TRANSMIT_BUFFER_FULL;
+        } else {
+            rb_put(dest->ring, (uintptr_t)msg);
+        }
+        unlock(&dest->ring_lock);
 
-    LockRetain(dest->ring_lock);
-    if (rb_is_full(dest->ring)) return CHANNEL_TRANSMIT_BUFFER_FULL;
-    rb_put(dest->ring, (uintptr_t)msg);
+        if (result == CHANNEL_TRANSMIT_SUCCESS) wait_queue_wake_one(dest->receivers);
+    }
 
-    return CHANNEL_TRANSMIT_SUCCESS;
+    rcu_read_unlock();
+    return result;
 }
 
 ChannelReceiveResult channel_receive(Channel* self, Package** msg) {
@@ -134,6 +175,27 @@ ChannelReceiveResult channel_receive(Channel* self, Package** msg) {
     return CHANNEL_RECEIVE_SUCCESS;
 }
 
+// *Receive a package from the channel, blocking the current task until one is transmitted
+// @param self the receiving channel
+// @param msg the received package
+// @return CHANNEL_RECEIVE_SUCCESS on success, or the reason the channel can't receive
+ChannelReceiveResult channel_receive_wait(Channel* self, Package** msg) {
+    if (!(self && channel_exists(self))) return CHANNEL_RECEIVE_BAD_RECEIVER;
+    if (!(self->flags & CHANNEL_CAN_RECEIVE)) return CHANNEL_RECEIVE_UNAUTHORIZED_RECEIVER;
+
+    lock(&self->ring_lock);
+    while (rb_is_empty(self->ring)) {
+        // the ring lock is released only once the task is queued, a transmit can't be missed
+        wait_queue_sleep(self->receivers, &self->ring_lock);
+        lock(&self->ring_lock);
+    }
+
+    rb_get(self->ring, (uintptr_t*)msg);
+    unlock(&self->ring_lock);
+
+    return CHANNEL_RECEIVE_SUCCESS;
+}
+
 ChannelPeekResult channel_peek(Channel* self, Package** msg) {
     if (!(self && channel_exists(self))) return CHANNEL_PEEK_BAD_RECEIVER;
     if (!(self->flags & CHANNEL_CAN_RECEIVE)) return CHANNEL_PEEK_UNAUTHORIZED_RECEIVER;
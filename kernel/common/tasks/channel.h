@@ -42,17 +42,22 @@ typedef struct __channel {
     Lock ring_lock;
     RingBufHandle ring;
     uintptr_t* _buffer;
+    struct __wait_queue* receivers;     // tasks blocked until a package is transmitted to the channel
+    volatile uint32_t refs;             // tasks sharing the channel, it's destroyed along with the last one
 } Channel;
 
 typedef struct __channel_agent_data {
     Channel* channel;
     Agent* agent;
+    struct __channel_agent_data* next;  // next entry of the registry, read under RCU
 } ChannelAgentData;
 
 Channel* NewChannel(ChannelFlag flags, const char* agent_name);
 void DestroyChannel(Channel* channel);
+Channel* channel_retain(Channel* channel);
 Channel* channel_find_by_agent_name(const char* name);
 Channel* channel_find_by_agent_id(AgentID id);
 ChannelTransmitResult channel_transmit(Channel* self, Channel* dest, Package* msg);
 ChannelReceiveResult channel_receive(Channel* self, Package** msg);
+ChannelReceiveResult channel_receive_wait(Channel* self, Package** msg);
 ChannelPeekResult channel_peek(Channel* self, Package** msg);
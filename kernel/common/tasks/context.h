@@ -19,3 +19,5 @@ typedef struct __context_flags {
 Context* NewContext();
 void DestroyContext(Context* context);
 void context_init(Context* context, uintptr_t ip, uintptr_t sp, uintptr_t ksp, ContextFlags cflags);
+void context_set_argument(Context* context, uintptr_t argument);
+void context_set_tls(Context* context, uintptr_t tls);
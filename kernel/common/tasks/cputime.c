@@ -0,0 +1,180 @@
+#include "cputime.h"
+#include "scheduler.h"
+#include "task.h"
+#include "pid.h"
+#include "arch.h"
+#include "kernel/common/cpu.h"
+#include "kernel/common/memory/memory.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <size_t.h>
+#include <_null.h>
+#include <neutrino/macros.h>
+
+#ifdef __x86_64
+#include "kernel/x86_64/interrupts.h"
+#else
+#error "Unsupported platform"
+#endif
+
+typedef struct __top_collector {
+    TopTask* tasks;
+    size_t count;                       // entries available in [tasks]
+    size_t filled;
+    size_t total;                       // tasks visited, including the ones that didn't fit
+} TopCollector;
+
+// decay of the averages on every sample, exp(-CPUTIME_SAMPLE_MS / window) in fixed point
+static const uint64_t load_decay[LOAD_AVERAGES] = {1853, 2007, 2034};
+
+static CpuLoad cpu_loads[MAX_CPU];
+
+// === PRIVATE FUNCTIONS ========================
+
+// *Decay a load average, then add a sample to it
+// @param load the load average to update
+// @param decay the decay of the average, see load_decay
+// @param runnable the sampled number of runnable tasks
+// @return the updated load average
+static inline uint64_t load_update(uint64_t load, uint64_t decay, uint64_t runnable) {
+    return (load * decay + (runnable << LOAD_FIXED_SHIFT) * (LOAD_FIXED_1 - decay)) >> LOAD_FIXED_SHIFT;
+}
+
+// *Convert the cycles of a CPU time to nanoseconds
+// @param time the CPU time, in cycles
+// @return the CPU time, in nanoseconds
+static inline CpuTime time_to_ns(CpuTime time) {
+    return (CpuTime){
+        .user = arch_cycles_to_ns(time.user),
+        .kernel = arch_cycles_to_ns(time.kernel),
+        .idle = arch_cycles_to_ns(time.idle)
+    };
+}
+
+// *Copy a task into the next entry of a top snapshot
+// @param task the visited task
+// @param data the TopCollector being filled
+// @return true, every task is counted
+bool top_collect(Task* task, void* data) {
+    TopCollector* collector = (TopCollector*)data;
+    collector->total++;
+    if (collector->filled >= collector->count) return true;
+
+    TopTask* entry = &collector->tasks[collector->filled++];
+    entry->pid = task->pid;
+    entry->cpu_id = task->cpu_affinity.cpu_id;
+    entry->status = task->status;
+    entry->priority = task->priority.level;
+    memory_copy((uint8_t*)task->name, (uint8_t*)entry->name, Min(TASK_NAME_MAX, TOP_NAME_MAX));
+    entry->name[Min(TASK_NAME_MAX, TOP_NAME_MAX)] = '\0';
+    entry->time = time_to_ns(task->cputime.total);
+    return true;
+}
+
+// === PUBLIC FUNCTIONS =========================
+
+// *Charge the cycles elapsed since the last charge of a CPU to the task it was running: idle time for the
+// *idle task, kernel time for kernel tasks and tasks in a syscall, user time otherwise.
+// *Must be called by the CPU itself with interrupts disabled
+// @param cpu the current CPU
+// @param task the task running on the CPU, or nullptr
+void cputime_charge(volatile Cpu* cpu, Task* task) {
+    CpuLoad* load = &cpu_loads[cpu->id];
+    uint64_t now = read_tsc();
+    uint64_t elapsed = (load->charged_at != 0) ? now - load->charged_at : 0;
+    load->charged_at = now;
+
+    if (task == nullptr) return;
+
+    if (task == cpu->tasks.idle) {
+        task->cputime.total.idle += elapsed;
+        load->total.idle += elapsed;
+    } else if (task->user && !task->in_syscall) {
+        task->cputime.total.user += elapsed;
+        load->total.user += elapsed;
+    } else {
+        task->cputime.total.kernel += elapsed;
+        load->total.kernel += elapsed;
+    }
+
+    task->cputime.last_ran = now;
+}
+
+// *Mark the current task as entering or leaving a syscall, charging the time it ran in the previous mode
+// @param entering true when the syscall starts, false when it returns
+void cputime_syscall(bool entering) {
+    bool enabled = interrupts_save();
+    volatile Cpu* cpu = get_current_cpu();
+    Task* task = cpu->tasks.current;
+
+    cputime_charge(cpu, task);
+    task->in_syscall = entering;
+
+    interrupts_restore(enabled);
+}
+
+// *Sample the number of runnable tasks of a CPU into its load averages, once every CPUTIME_SAMPLE_MS.
+// *Samples skipped while the CPU was tickless are applied as idle samples. Called on every scheduler cycle
+// @param cpu the current CPU
+// @param runnable the tasks running or queued on the CPU
+void cputime_sample(volatile Cpu* cpu, uint32_t runnable) {
+    CpuLoad* load = &cpu_loads[cpu->id];
+    uint64_t now = read_tsc();
+    uint64_t busy = load->total.user + load->total.kernel;
+
+    if (load->sampled_at == 0) {
+        load->sampled_at = now;
+        load->busy_at_sample = busy;
+        return;
+    }
+
+    uint64_t period = arch_ns_to_cycles(CPUTIME_SAMPLE_MS * 1000000ull), elapsed = now - load->sampled_at;
+    if (period == 0 || elapsed < period) return;
+
+    uint64_t samples = Min(elapsed / period, CPUTIME_SAMPLES_MAX);
+    for (size_t i = 0; i < LOAD_AVERAGES; i++) {
+        for (uint64_t j = 1; j < samples; j++) load->load[i] = load_update(load->load[i], load_decay[i], 0);
+        load->load[i] = load_update(load->load[i], load_decay[i], runnable);
+    }
+
+    load->utilisation = Min((busy - load->busy_at_sample) * 1000 / elapsed, 1000);
+    load->sampled_at = now;
+    load->busy_at_sample = busy;
+}
+
+// *Get the CPU time and the load of a CPU
+// @param cpu_id the id of the CPU
+// @return the load of the CPU, or nullptr if the CPU doesn't exist
+CpuLoad* cputime_of(uint32_t cpu_id) {
+    if (cpu_id >= get_cpu_count()) return nullptr;
+    return &cpu_loads[cpu_id];
+}
+
+// *Take a snapshot of the CPU time of every task
+// @param tasks the entries to fill
+// @param count the number of entries available
+// @param total set to the number of tasks, which may be more than the filled entries
+// @return the number of filled entries
+size_t cputime_top(TopTask* tasks, size_t count, size_t* total) {
+    TopCollector collector = {.tasks = tasks, .count = count, .filled = 0, .total = 0};
+    pid_foreach(0, top_collect, &collector);
+
+    if (total != nullptr) *total = collector.total;
+    return collector.filled;
+}
+
+// *Take a snapshot of the CPU time and the load of a CPU
+// @param cpu_id the id of the CPU
+// @param cpu the entry to fill
+// @return false if the CPU doesn't exist, true otherwise
+bool cputime_top_cpu(uint32_t cpu_id, TopCpu* cpu) {
+    CpuLoad* load = cputime_of(cpu_id);
+    if (load == nullptr) return false;
+
+    cpu->time = time_to_ns(load->total);
+    for (size_t i = 0; i < LOAD_AVERAGES; i++) cpu->load[i] = load->load[i];
+    cpu->utilisation = load->utilisation;
+    cpu->runnable = scheduler.queues[cpu_id].count + (get_cpu(cpu_id)->tasks.current != get_cpu(cpu_id)->tasks.idle);
+
+    return true;
+}
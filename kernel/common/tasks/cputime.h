@@ -0,0 +1,27 @@
+#pragma once
+#include "task.h"
+#include "../cpu.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <size_t.h>
+#include <neutrino/cputime.h>
+
+#define CPUTIME_SAMPLE_MS   100     // time between two samples of the load of a CPU
+#define CPUTIME_SAMPLES_MAX 256     // samples missed by a tickless CPU applied at once, enough to decay every average
+
+typedef struct __cpu_load {
+    CpuTime total;                      // cycles charged on the CPU
+    uint64_t charged_at;                // cycle counter when a task was last charged, 0 before the first one
+    uint64_t load[LOAD_AVERAGES];       // runnable tasks, averaged over 1, 5 and 15 seconds
+    uint64_t sampled_at;                // cycle counter of the last load sample
+    uint64_t busy_at_sample;            // user and kernel cycles charged at the last load sample
+    uint32_t utilisation;               // busy cycles over the last sample, per mille
+} CpuLoad;
+
+void cputime_charge(volatile Cpu* cpu, Task* task);
+void cputime_syscall(bool entering);
+void cputime_sample(volatile Cpu* cpu, uint32_t runnable);
+CpuLoad* cputime_of(uint32_t cpu_id);
+
+size_t cputime_top(TopTask* tasks, size_t count, size_t* total);
+bool cputime_top_cpu(uint32_t cpu_id, TopCpu* cpu);
@@ -0,0 +1,111 @@
+#include "futex.h"
+#include "scheduler.h"
+#include "task.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <size_t.h>
+#include <_null.h>
+#include <neutrino/lock.h>
+
+#ifdef __x86_64
+#include "kernel/x86_64/interrupts.h"
+#else
+#error "Unsupported platform"
+#endif
+
+static FutexBucket futex_table[FUTEX_BUCKETS];
+
+// === PRIVATE FUNCTIONS ========================
+
+// *Get the bucket of a futex
+// @param space the address space of the futex
+// @param address the virtual address of the futex
+// @return the bucket holding the waiters of the futex
+static inline FutexBucket* futex_bucket_of(Space* space, uintptr_t address) {
+    uint64_t key = (address >> 2) ^ ((uintptr_t)space >> 4);
+    key *= 0x9e3779b97f4a7c15ull;
+    return &futex_table[key >> (64 - FUTEX_BUCKET_BITS)];
+}
+
+// === PUBLIC FUNCTIONS =========================
+
+// *Block the current task on a futex of its space, only if the futex still holds [expected]. The value is
+// *checked with the bucket locked, so that a wake following a change of the value can't be missed. It's read
+// *through the page tables of the space, since another thread may unmap it while the bucket is locked
+// @param address the futex
+// @param expected the value the caller saw before deciding to wait
+// @return FUTEX_WAIT_WOKEN once woken up, or the reason the task didn't wait
+FutexWaitResult futex_wait(volatile uint32_t* address, uint32_t expected) {
+    Task* task = get_current_task();
+    FutexWaiter waiter = {.task = task, .space = task->space, .address = (uintptr_t)address, .next = nullptr};
+    FutexBucket* bucket = futex_bucket_of(waiter.space, waiter.address);
+
+    bool enabled = interrupts_save();
+    lock(&bucket->lock);
+
+    uint32_t value;
+    bool mapped = space_read_user_u32(waiter.space, waiter.address, &value);
+    if (!mapped || value != expected) {
+        unlock(&bucket->lock);
+        interrupts_restore(enabled);
+        return mapped ? FUTEX_WAIT_CHANGED : FUTEX_WAIT_UNMAPPED;
+    }
+
+    // the waiter is kept in the stack of the task until a wake unlinks it
+    if (bucket->tail != nullptr) bucket->tail->next = &waiter;
+    else bucket->head = &waiter;
+    bucket->tail = &waiter;
+
+    task->status = TASK_BLOCKED;
+    unlock(&bucket->lock);
+
+    sched_yield();
+    interrupts_restore(enabled);
+    return FUTEX_WAIT_WOKEN;
+}
+
+// *Wake up to [count] tasks waiting on a futex of the current space, the ones waiting for the longest time first
+// @param address the futex
+// @param count the maximum number of tasks to wake up
+// @return the number of woken up tasks
+size_t futex_wake(volatile uint32_t* address, size_t count) {
+    Space* space = get_current_task()->space;
+    FutexBucket* bucket = futex_bucket_of(space, (uintptr_t)address);
+    FutexWaiter* woken = nullptr;
+    FutexWaiter** woken_tail = &woken;
+    size_t found = 0;
+
+    bool enabled = interrupts_save();
+    lock(&bucket->lock);
+
+    FutexWaiter** p = &bucket->head;
+    FutexWaiter* prev = nullptr;
+    while (*p != nullptr && found < count) {
+        FutexWaiter* waiter = *p;
+        if (waiter->space != space || waiter->address != (uintptr_t)address) {
+            prev = waiter;
+            p = &waiter->next;
+            continue;
+        }
+
+        *p = waiter->next;
+        if (bucket->tail == waiter) bucket->tail = prev;
+
+        waiter->next = nullptr;
+        *woken_tail = waiter;
+        woken_tail = &waiter->next;
+        found++;
+    }
+
+    unlock(&bucket->lock);
+
+    // the waiters live in the stacks of their tasks, they're read before the tasks can run again
+    while (woken != nullptr) {
+        FutexWaiter* next = woken->next;
+        sched_wake(woken->task);
+        woken = next;
+    }
+
+    interrupts_restore(enabled);
+    return found;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "task.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <size_t.h>
+#include <neutrino/lock.h>
+
+#define FUTEX_BUCKET_BITS   8
+#define FUTEX_BUCKETS       (1 << FUTEX_BUCKET_BITS)    // wait queues of the futex table, futexes may share one
+#define FUTEX_USER_END      0x0000800000000000          // futexes are in the lower half, owned by user tasks
+
+typedef struct __futex_waiter {
+    Task* task;
+    Space* space;                   // futexes are told apart by address space and virtual address
+    uintptr_t address;
+    struct __futex_waiter* next;
+} FutexWaiter;
+
+typedef struct __futex_bucket {
+    Lock lock;
+    FutexWaiter* head;              // waiters, in the order they started waiting
+    FutexWaiter* tail;
+} FutexBucket;
+
+typedef enum __futex_wait_result {
+    FUTEX_WAIT_WOKEN,
+    FUTEX_WAIT_CHANGED,             // the futex didn't hold the expected value
+    FUTEX_WAIT_UNMAPPED             // the futex is not mapped readable in the space of the task
+} FutexWaitResult;
+
+FutexWaitResult futex_wait(volatile uint32_t* address, uint32_t expected);
+size_t futex_wake(volatile uint32_t* address, size_t count);
@@ -12,7 +12,7 @@
 #include <neutrino/macros.h>
 #include <neutrino/lock.h>
 
-Lock loader_lock = NewLock;
+Lock loader_lock = NewNamedLock("loader");
 
 // === PRIVATE FUNCTIONS ========================
 
@@ -25,7 +25,7 @@ void load_elf(const Elf64Header* header, const uintptr_t binary, Task* task) {
             continue;
         }
         
-        size_t size = AlignUp(Max(prg_header->mem_size, prg_header->file_size), PAGE_SIZE);
+        size_t size = AlignUp(Max(prg_header->mem_size, prg_header->file_size) + (prg_header->file_offset % PAGE_SIZE), PAGE_SIZE);
         VirtualMapping vmap = memory_allocate(size);
         space_map(task->space, vmap.physical.base, vmap.virtual_base, size, MAP_WRITABLE);
         
@@ -58,7 +58,7 @@ void load_elf(const Elf64Header* header, const uintptr_t binary, Task* task) {
 
 // === PUBLIC FUNCTIONS =========================
 
-void unoptimized load_binary(const uintptr_t binary, char* binary_name, bool user) {
+void load_binary(const uintptr_t binary, char* binary_name, bool user) {
     LockRetain(loader_lock);
     // check for ELF and validate
     if (elf_check((const Elf64Header*)binary)) {
@@ -73,6 +73,8 @@ void unoptimized load_binary(const uintptr_t binary, char* binary_name, bool use
 
         ks.log("Loading ELF \"%c\"...", binary_name);
         Task* elf_task = NewTask(binary_name, user);
+        if (elf_task == nullptr) return;
+
         load_elf(h, binary, elf_task);
         sched_start(elf_task, h->entry_point);
 
@@ -0,0 +1,178 @@
+#include "pid.h"
+#include "task.h"
+#include "rcu.h"
+#include "kernel/common/kservice.h"
+#include "kernel/common/memory/memory.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <size_t.h>
+#include <_null.h>
+#include <liballoc.h>
+#include <neutrino/lock.h>
+
+#ifdef __x86_64
+#include "kernel/x86_64/interrupts.h"
+#else
+#error "Unsupported platform"
+#endif
+
+static PidTable pid_table = {.lock = NewNamedLock("pid table"), .next = 0, .count = 0};
+
+// === PRIVATE FUNCTIONS ========================
+
+// *Find a free pid, starting from the one after the last allocated pid, so that freed pids are reused as late
+// *as possible. The table must be locked
+// @return the free pid, or TASK_PID_NONE if every pid is allocated
+uint32_t pid_find_free() {
+    if (pid_table.count >= PID_MAX) return TASK_PID_NONE;
+
+    uint32_t start = pid_table.next / 64;
+    for (uint32_t i = 0; i <= PID_BITMAP_WORDS; i++) {
+        uint32_t word = (start + i) % PID_BITMAP_WORDS;
+        uint64_t free = ~pid_table.bitmap[word];
+
+        // the pids before [next] in its word are only taken once the search wraps around
+        if (i == 0) free &= ~0ull << (pid_table.next % 64);
+        if (free != 0) return word * 64 + __builtin_ctzll(free);
+    }
+
+    return TASK_PID_NONE;
+}
+
+// *Allocate an empty leaf. The heap is only locked with interrupts enabled, so the table must not be locked
+// @return the leaf, or nullptr if it can't be allocated
+PidLeaf* pid_leaf_new() {
+    PidLeaf* leaf = (PidLeaf*)kmalloc(sizeof(PidLeaf));
+    if (leaf != nullptr) memory_set((uint8_t*)leaf, 0, sizeof(PidLeaf));
+    return leaf;
+}
+
+// === PUBLIC FUNCTIONS =========================
+
+// *Allocate a pid. Freed pids are recycled once the allocation wraps around PID_MAX. When the pid has no leaf
+// *yet, one is allocated with the table unlocked and the search is done again, since the table may have changed
+// @return the new pid, or TASK_PID_NONE if no pid is free
+uint32_t pid_alloc() {
+    PidLeaf* spare = nullptr;
+    uint32_t pid;
+
+    while (true) {
+        bool enabled = interrupts_save();
+        lock(&pid_table.lock);
+
+        pid = pid_find_free();
+        bool missing = (pid != TASK_PID_NONE && pid_table.leaves[pid >> PID_LEAF_BITS] == nullptr);
+        if (missing && spare != nullptr) {
+            // the leaf is cleared before readers can see it
+            __atomic_store_n(&pid_table.leaves[pid >> PID_LEAF_BITS], spare, __ATOMIC_RELEASE);
+            spare = nullptr;
+            missing = false;
+        }
+
+        if (pid != TASK_PID_NONE && !missing) {
+            pid_table.bitmap[pid / 64] |= (1ull << (pid % 64));
+            pid_table.next = (pid + 1) % PID_MAX;
+            pid_table.count++;
+        }
+
+        unlock(&pid_table.lock);
+        interrupts_restore(enabled);
+        if (!missing) break;
+
+        spare = pid_leaf_new();
+        if (spare == nullptr) return TASK_PID_NONE;
+    }
+
+    // another task installed the leaf meanwhile
+    if (spare != nullptr) kfree(spare);
+    return pid;
+}
+
+// *Make a task reachable through its pid
+// @param pid the pid returned by pid_alloc()
+// @param task the task, the fields read by the readers of the table must be initialized
+void pid_publish(uint32_t pid, Task* task) {
+    PidLeaf* leaf = pid_table.leaves[pid >> PID_LEAF_BITS];
+    __atomic_store_n(&leaf->tasks[pid & (PID_LEAF_SIZE - 1)], task, __ATOMIC_RELEASE);
+}
+
+// *Remove the task of a pid from the table, without freeing the pid: it stays reserved while the exit status
+// *of the task can be collected. The task must not be freed before pid_synchronize() returns
+// @param pid the pid of the task being destroyed
+void pid_unlink(uint32_t pid) {
+    if (pid >= PID_MAX) return;
+
+    PidLeaf* leaf = pid_table.leaves[pid >> PID_LEAF_BITS];
+    if (leaf != nullptr) __atomic_store_n(&leaf->tasks[pid & (PID_LEAF_SIZE - 1)], nullptr, __ATOMIC_RELEASE);
+}
+
+// *Give back a pid, once nobody can refer to it anymore
+// @param pid the pid to free
+void pid_free(uint32_t pid) {
+    if (pid >= PID_MAX) return;
+    bool enabled = interrupts_save();
+    lock(&pid_table.lock);
+
+    if (pid_table.bitmap[pid / 64] & (1ull << (pid % 64))) {
+        pid_table.bitmap[pid / 64] &= ~(1ull << (pid % 64));
+        pid_table.count--;
+    }
+
+    unlock(&pid_table.lock);
+    interrupts_restore(enabled);
+}
+
+// *Start reading the table. Tasks found until pid_read_end() can't be freed, but may be terminating.
+// *Interrupts are disabled, so the section is an RCU read section as well: it must be short and must not block
+// @return the interrupt state, given to pid_read_end()
+bool pid_read_begin() {
+    return interrupts_save();
+}
+
+// *Stop reading the table
+// @param enabled the interrupt state returned by pid_read_begin()
+void pid_read_end(bool enabled) {
+    interrupts_restore(enabled);
+}
+
+// *Wait until every reader of the table is done, so that the tasks unlinked before can be freed
+void pid_synchronize() {
+    rcu_synchronize();
+}
+
+// *Find the task of a pid in O(1). Must be called between pid_read_begin() and pid_read_end()
+// @param pid the pid of the task
+// @return the task, or nullptr if no task has the pid
+Task* pid_lookup(uint32_t pid) {
+    if (pid >= PID_MAX) return nullptr;
+
+    PidLeaf* leaf = __atomic_load_n(&pid_table.leaves[pid >> PID_LEAF_BITS], __ATOMIC_ACQUIRE);
+    if (leaf == nullptr) return nullptr;
+
+    return __atomic_load_n(&leaf->tasks[pid & (PID_LEAF_SIZE - 1)], __ATOMIC_ACQUIRE);
+}
+
+// *Call [visitor] on every task, in pid order, without locking the table. Tasks created or destroyed
+// *meanwhile may or may not be visited. The visitor runs in a read section, it must not block
+// @param from the first pid to visit
+// @param visitor the function called on every task, returning false to stop
+// @param data the argument given to the visitor
+void pid_foreach(uint32_t from, TaskVisitor visitor, void* data) {
+    bool enabled = pid_read_begin();
+
+    for (uint32_t l = from >> PID_LEAF_BITS; l < PID_LEAF_COUNT; l++) {
+        PidLeaf* leaf = __atomic_load_n(&pid_table.leaves[l], __ATOMIC_ACQUIRE);
+        if (leaf == nullptr) continue;
+
+        uint32_t first = (l == (from >> PID_LEAF_BITS)) ? from & (PID_LEAF_SIZE - 1) : 0;
+        for (uint32_t i = first; i < PID_LEAF_SIZE; i++) {
+            Task* task = __atomic_load_n(&leaf->tasks[i], __ATOMIC_ACQUIRE);
+            if (task != nullptr && !visitor(task, data)) {
+                pid_read_end(enabled);
+                return;
+            }
+        }
+    }
+
+    pid_read_end(enabled);
+}
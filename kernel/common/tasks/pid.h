@@ -0,0 +1,36 @@
+#pragma once
+#include "task.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <size_t.h>
+#include <neutrino/lock.h>
+
+#define PID_MAX             32768   // pids are allocated in [0, PID_MAX)
+#define PID_LEAF_BITS       8
+#define PID_LEAF_SIZE       (1 << PID_LEAF_BITS)
+#define PID_LEAF_COUNT      (PID_MAX / PID_LEAF_SIZE)
+#define PID_BITMAP_WORDS    (PID_MAX / 64)
+
+typedef struct __pid_leaf {
+    Task* volatile tasks[PID_LEAF_SIZE];
+} PidLeaf;
+
+typedef struct __pid_table {
+    Lock lock;                                  // serializes the writers, readers never take it
+    PidLeaf* volatile leaves[PID_LEAF_COUNT];   // allocated on first use and never freed
+    uint64_t bitmap[PID_BITMAP_WORDS];          // bit n is set while pid n is allocated
+    uint32_t next;                              // first pid checked by the next allocation
+    size_t count;                               // allocated pids
+} PidTable;
+
+uint32_t pid_alloc();
+void pid_publish(uint32_t pid, Task* task);
+void pid_unlink(uint32_t pid);
+void pid_free(uint32_t pid);
+
+bool pid_read_begin();
+void pid_read_end(bool enabled);
+void pid_synchronize();
+
+Task* pid_lookup(uint32_t pid);
+void pid_foreach(uint32_t from, TaskVisitor visitor, void* data);
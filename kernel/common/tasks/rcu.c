@@ -0,0 +1,51 @@
+#include "rcu.h"
+#include "arch.h"
+#include "scheduler.h"
+#include "kernel/common/cpu.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <size_t.h>
+
+static RcuCpu rcu_cpus[MAX_CPU];
+
+// === PUBLIC FUNCTIONS =========================
+
+// *Report a quiescent state of a CPU. Called on every scheduler cycle, which never runs inside a read section
+// @param cpu the current CPU
+void rcu_quiescent(volatile Cpu* cpu) {
+    __atomic_add_fetch(&rcu_cpus[cpu->id].quiescent, 1, __ATOMIC_RELEASE);
+}
+
+// *Wait for a grace period: every read section running when called has ended once it returns, so that the
+// *objects unpublished before can be freed. CPUs that don't run the scheduler for RCU_KICK_NS are kicked.
+// *Must not be called inside a read section or with interrupts disabled
+void rcu_synchronize() {
+    if (!scheduler.ready) return;
+
+    // the unpublishing stores must be visible before the quiescent states are sampled
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    size_t count = get_cpu_count();
+    uint64_t snapshot[MAX_CPU];
+    for (size_t i = 0; i < count; i++) snapshot[i] = __atomic_load_n(&rcu_cpus[i].quiescent, __ATOMIC_ACQUIRE);
+
+    // the caller is not reading, its CPU is in a quiescent state already
+    uint32_t self = get_current_cpu()->id;
+    uint64_t kick_after = arch_ns_to_cycles(RCU_KICK_NS);
+
+    for (size_t i = 0; i < count; i++) {
+        if (i == self) continue;
+
+        uint64_t start = read_tsc();
+        bool kicked = false;
+
+        while (__atomic_load_n(&rcu_cpus[i].quiescent, __ATOMIC_ACQUIRE) == snapshot[i]) {
+            if (!kicked && read_tsc() - start >= kick_after) {
+                cpu_kick(i);
+                kicked = true;
+            }
+
+            asm volatile ("pause");
+        }
+    }
+}
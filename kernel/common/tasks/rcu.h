@@ -0,0 +1,34 @@
+#pragma once
+#include "scheduler.h"
+#include "../cpu.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <neutrino/macros.h>
+
+#define RCU_KICK_NS     2000000     // a CPU not passing a quiescent state for this long is made to run the scheduler
+
+// Read-copy-update, based on quiescent states: a CPU running the scheduler is not in a read section, since read
+// sections can't be preempted. Once every CPU ran the scheduler, no reader can still see what was unpublished before
+
+typedef struct __rcu_cpu {
+    volatile uint64_t quiescent aligned(64);   // quiescent states passed by the CPU, on its own cache line
+} RcuCpu;
+
+// *Read a pointer published with RcuAssign(), inside a read section
+#define RcuDereference(p)       __atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+
+// *Publish a pointer to readers, once the object it points to is initialized
+#define RcuAssign(p, value)     __atomic_store_n(&(p), value, __ATOMIC_RELEASE)
+
+// *Start a read section. Objects found until rcu_read_unlock() can't be freed. The section can't block
+static inline void rcu_read_lock() {
+    preempt_disable();
+}
+
+// *End a read section
+static inline void rcu_read_unlock() {
+    preempt_enable();
+}
+
+void rcu_quiescent(volatile Cpu* cpu);
+void rcu_synchronize();
@@ -0,0 +1,155 @@
+#include "reaper.h"
+#include "scheduler.h"
+#include "waitqueue.h"
+#include "task.h"
+#include "pid.h"
+#include "kernel/common/cpu.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <_null.h>
+#include <liballoc.h>
+#include <neutrino/lock.h>
+
+#ifdef __x86_64
+#include "kernel/x86_64/interrupts.h"
+#else
+#error "Unsupported platform"
+#endif
+
+static ExitRecord* exit_records = nullptr;
+static Lock exit_lock = NewNamedLock("exit records");
+static WaitQueue exit_waiters = {.lock = NewLock, .tasks = NewTaskQueue};
+
+// === PRIVATE FUNCTIONS ========================
+
+// *Record the exit status of a destroyed task and wake up the tasks waiting for it.
+// *Records of the children of the task are dropped, since nobody can wait for them anymore, and their pids freed
+// @param pid the pid of the destroyed task
+// @param status the exit status of the task
+void reaper_complete(uint32_t pid, uint32_t status) {
+    lock(&exit_lock);
+
+    ExitRecord** link = &exit_records;
+    while (*link != nullptr) {
+        ExitRecord* record = *link;
+
+        if (record->pid == pid) {
+            record->exited = true;
+            record->status = status;
+        }
+
+        if (record->parent_pid == pid) record->parent_pid = TASK_PID_NONE;
+
+        if (record->exited && record->parent_pid == TASK_PID_NONE) {
+            *link = record->next;
+            pid_free(record->pid);
+            kfree(record);
+        } else {
+            link = &record->next;
+        }
+    }
+
+    unlock(&exit_lock);
+    wait_queue_wake_all(&exit_waiters);
+}
+
+// *Body of the reaper task of a CPU. Zombies are taken in batches with interrupts disabled, then destroyed
+// *with interrupts enabled, so that the teardown of large processes doesn't delay the timer interrupt
+void reaper_main() {
+    while (true) {
+        bool enabled = interrupts_save();
+        volatile Cpu* cpu = get_current_cpu();
+
+        // no zombie can be queued while interrupts are off, since only this CPU queues them
+        if (cpu->tasks.zombies.count == 0) {
+            cpu->tasks.reaper->status = TASK_BLOCKED;
+            sched_yield();
+            interrupts_restore(enabled);
+            continue;
+        }
+
+        TaskQueue batch = cpu->tasks.zombies;
+        cpu->tasks.zombies = NewTaskQueue;
+        interrupts_restore(enabled);
+
+        Task* zombie;
+        while ((zombie = task_queue_pop(&batch)) != nullptr) {
+            uint32_t pid = zombie->pid, status = zombie->exit_status;
+            DestroyTask(zombie);
+            reaper_complete(pid, status);
+        }
+    }
+}
+
+// === PUBLIC FUNCTIONS =========================
+
+// *Create and start the reaper task of a CPU, pinned to it
+// @param cpu the CPU to create the reaper for
+void init_reaper(volatile Cpu* cpu) {
+    cpu->tasks.zombies = NewTaskQueue;
+
+    Task* reaper = NewTask("reaper", false);
+    reaper->cpu_affinity.cpu_id = cpu->id;
+    reaper->cpu_affinity.allowed = reaper->cpu_affinity.preferred = NewCpuMask;
+    cpu_mask_set(&reaper->cpu_affinity.allowed, cpu->id);
+    cpu_mask_set(&reaper->cpu_affinity.preferred, cpu->id);
+
+    cpu->tasks.reaper = reaper;
+    sched_start(reaper, (uintptr_t)reaper_main);
+}
+
+// *Start keeping the exit status of a task, so that its parent can wait for it
+// @param task the task being started
+void reaper_track(Task* task) {
+    ExitRecord* record = (ExitRecord*)kmalloc(sizeof(ExitRecord));
+    *record = (ExitRecord){.pid = task->pid, .parent_pid = task->parent_pid, .exited = false, .status = 0};
+
+    LockRetain(exit_lock);
+    record->next = exit_records;
+    exit_records = record;
+}
+
+// *Hand a terminated task to the reaper of the CPU. Called by the scheduler with interrupts disabled,
+// *while the CPU may still be on the kernel stack of the task: it's destroyed once the reaper runs
+// @param cpu the CPU the task terminated on
+// @param zombie the terminated task
+void reaper_collect(volatile Cpu* cpu, Task* zombie) {
+    task_queue_push((TaskQueue*)&cpu->tasks.zombies, zombie);
+
+    if (cpu->tasks.reaper != nullptr && cpu->tasks.reaper->status == TASK_BLOCKED)
+        sched_wake(cpu->tasks.reaper);
+}
+
+// *Block until a child task is destroyed, then collect its exit status
+// @param parent_pid the pid of the waiting task
+// @param pid the pid of the task to wait for
+// @param status the exit status of the task, set on success
+// @return REAPER_WAIT_SUCCESS once the task is destroyed, or the reason it can't be waited for
+ReaperWaitResult reaper_wait(uint32_t parent_pid, uint32_t pid, uint32_t* status) {
+    lock(&exit_lock);
+
+    while (true) {
+        ExitRecord** link = &exit_records;
+        while (*link != nullptr && (*link)->pid != pid) link = &(*link)->next;
+
+        ExitRecord* record = *link;
+        if (record == nullptr || record->parent_pid != parent_pid) {
+            unlock(&exit_lock);
+            return (record == nullptr) ? REAPER_WAIT_NO_TASK : REAPER_WAIT_NOT_CHILD;
+        }
+
+        if (record->exited) {
+            *status = record->status;
+            *link = record->next;
+            unlock(&exit_lock);
+
+            kfree(record);
+            pid_free(pid);
+            return REAPER_WAIT_SUCCESS;
+        }
+
+        // the lock is released once the task is queued, an exit can't be missed
+        wait_queue_sleep(&exit_waiters, &exit_lock);
+        lock(&exit_lock);
+    }
+}
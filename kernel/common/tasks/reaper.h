@@ -0,0 +1,25 @@
+#pragma once
+#include "task.h"
+#include "../cpu.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <neutrino/lock.h>
+
+typedef struct __exit_record {
+    uint32_t pid;
+    uint32_t parent_pid;            // TASK_PID_NONE if nobody can wait for the task
+    bool exited;
+    uint32_t status;
+    struct __exit_record* next;
+} ExitRecord;
+
+typedef enum __reaper_wait_result {
+    REAPER_WAIT_SUCCESS,
+    REAPER_WAIT_NO_TASK,            // no task with the given pid is running or waiting to be collected
+    REAPER_WAIT_NOT_CHILD           // the task was not started by the waiting task
+} ReaperWaitResult;
+
+void init_reaper(volatile Cpu* cpu);
+void reaper_track(Task* task);
+void reaper_collect(volatile Cpu* cpu, Task* zombie);
+ReaperWaitResult reaper_wait(uint32_t parent_pid, uint32_t pid, uint32_t* status);
@@ -0,0 +1,161 @@
+#include "schedstat.h"
+#include "scheduler.h"
+#include "task.h"
+#include "arch.h"
+#include "kernel/common/cpu.h"
+#include "kernel/common/kservice.h"
+#include "kernel/common/memory/memory.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <neutrino/lock.h>
+#include <neutrino/macros.h>
+
+#ifdef __x86_64
+#include "kernel/x86_64/interrupts.h"
+#else
+#error "Unsupported platform"
+#endif
+
+typedef struct __schedstat_entry {
+    uint32_t pid;
+    char name[TASK_NAME_MAX+1];
+    SchedTaskStats stats;
+} SchedStatEntry;
+
+volatile bool schedstat_enabled = false;
+static SchedCpuStats schedstat_cpus[MAX_CPU];
+
+// === PRIVATE FUNCTIONS ========================
+
+// *Add a sample to a histogram
+// @param histogram the histogram to update
+// @param cycles the sample, in cycles
+static inline void histogram_add(SchedHistogram* histogram, uint64_t cycles) {
+    uint8_t bucket = (cycles == 0) ? 0 : 63 - __builtin_clzll(cycles);
+    if (bucket >= SCHED_HISTOGRAM_BUCKETS) bucket = SCHED_HISTOGRAM_BUCKETS - 1;
+
+    histogram->buckets[bucket]++;
+    histogram->count++;
+    histogram->total += cycles;
+    if (cycles > histogram->max) histogram->max = cycles;
+}
+
+// *Print the non-empty buckets of a histogram on the serial output
+// @param name the name of the histogram
+// @param histogram the histogram to print
+void histogram_dump(char* name, SchedHistogram* histogram) {
+    uint64_t average = (histogram->count > 0) ? histogram->total / histogram->count : 0;
+    ks.log("  %c: %u samples, average %u cycles, max %u cycles", name, histogram->count, average, histogram->max);
+
+    for (uint8_t i = 0; i < SCHED_HISTOGRAM_BUCKETS; i++) {
+        if (histogram->buckets[i] == 0) continue;
+        ks.log("    >= 2^%u cycles: %u", (uint64_t)i, histogram->buckets[i]);
+    }
+}
+
+// *Copy the statistics of a task into a dump entry
+// @param entry the entry to fill
+// @param task the task to copy the statistics of
+static inline void entry_fill(SchedStatEntry* entry, Task* task) {
+    entry->pid = task->pid;
+    memory_copy((uint8_t*)task->name, (uint8_t*)entry->name, TASK_NAME_MAX+1);
+    entry->stats = task->stats.total;
+}
+
+// *Take a snapshot of the current and queued tasks of a CPU.
+// *Nothing is printed while the run queue is locked, since the serial output may be held by a task of that CPU
+// @param cpu_id the CPU to take the snapshot of
+// @param entries the entries to fill, at least SCHEDSTAT_DUMP_MAX
+// @return the number of filled entries
+size_t cpu_snapshot(uint32_t cpu_id, SchedStatEntry* entries) {
+    RunQueue* queue = &scheduler.queues[cpu_id];
+    volatile Cpu* cpu = get_cpu(cpu_id);
+    size_t count = 0;
+
+    bool enabled = interrupts_save();
+    ticket_lock(&queue->lock);
+
+    Task* current = cpu->tasks.current;
+    if (current != nullptr && current != cpu->tasks.idle)
+        entry_fill(&entries[count++], current);
+
+    for (uint8_t level = 0; level < TASK_PRIORITY_LEVELS; level++) {
+        for (Task* task = queue->levels[level].head; task != nullptr && count < SCHEDSTAT_DUMP_MAX; task = task->queue_next)
+            entry_fill(&entries[count++], task);
+    }
+
+    ticket_unlock(&queue->lock);
+    interrupts_restore(enabled);
+    return count;
+}
+
+// === PUBLIC FUNCTIONS =========================
+
+// *Start or stop collecting the scheduler statistics
+// @param enabled true to start collecting
+void schedstat_enable(bool enabled) {
+    schedstat_enabled = enabled;
+}
+
+// *Clear the histograms of every CPU. The statistics of the tasks are kept, since they're owned by the tasks
+void schedstat_reset() {
+    memory_set((uint8_t*)schedstat_cpus, 0, sizeof(schedstat_cpus));
+}
+
+// *Get the histograms of a CPU
+// @param cpu_id the id of the CPU
+// @return the statistics of the CPU, or nullptr if the CPU doesn't exist
+SchedCpuStats* schedstat_of(uint32_t cpu_id) {
+    if (cpu_id >= get_cpu_count()) return nullptr;
+    return &schedstat_cpus[cpu_id];
+}
+
+// *Account a scheduler cycle: the run time of the task leaving the CPU and the wait time of the task taking it.
+// *Must be called by the CPU running the cycle, with interrupts disabled
+// @param cpu the CPU running the cycle
+// @param prev the task that was running, or nullptr
+// @param next the task chosen to run
+void schedstat_record_switch(volatile Cpu* cpu, Task* prev, Task* next) {
+    if (likely(!schedstat_enabled) || prev == next) return;
+    uint64_t now = read_tsc();
+
+    if (prev != nullptr && prev->stats.started_at != 0)
+        prev->stats.total.run_cycles += now - prev->stats.started_at;
+
+    if (next->stats.queued_at != 0) {
+        uint64_t waited = now - next->stats.queued_at;
+        next->stats.total.wait_cycles += waited;
+        if (next->stats.woken) histogram_add(&schedstat_cpus[cpu->id].wakeup_latency, waited);
+        next->stats.queued_at = 0;
+    }
+
+    next->stats.started_at = now;
+    next->stats.total.switches++;
+}
+
+// *Account the duration of a context switch done by the timer handler
+// @param cpu the CPU running the handler
+// @param start the timestamp returned by schedstat_begin() when the handler started
+void schedstat_record_timer(volatile Cpu* cpu, uint64_t start) {
+    if (start == 0) return;
+    histogram_add(&schedstat_cpus[cpu->id].timer_handler, read_tsc() - start);
+}
+
+// *Print the histograms of every CPU and the statistics of the tasks they are running or have queued
+void schedstat_dump() {
+    SchedStatEntry entries[SCHEDSTAT_DUMP_MAX];
+
+    ks.log("Scheduler statistics (%c):", (schedstat_enabled) ? "enabled" : "disabled");
+    for (uint32_t i = 0; i < get_cpu_count(); i++) {
+        ks.log("CPU %u", (uint64_t)i);
+        histogram_dump("wakeup latency", &schedstat_cpus[i].wakeup_latency);
+        histogram_dump("timer handler", &schedstat_cpus[i].timer_handler);
+
+        size_t count = cpu_snapshot(i, entries);
+        for (size_t j = 0; j < count; j++) {
+            ks.log("  task #%u (%c): waited %u cycles, ran %u cycles, %u switches, %u wakeups",
+                   (uint64_t)entries[j].pid, entries[j].name, entries[j].stats.wait_cycles, entries[j].stats.run_cycles,
+                   entries[j].stats.switches, entries[j].stats.wakeups);
+        }
+    }
+}
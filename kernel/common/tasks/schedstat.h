@@ -0,0 +1,37 @@
+#pragma once
+#include "task.h"
+#include "../cpu.h"
+#include "arch.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <neutrino/macros.h>
+#include <neutrino/schedstat.h>
+
+#define SCHEDSTAT_DUMP_MAX  16      // queued tasks printed for each CPU by a dump
+
+extern volatile bool schedstat_enabled;
+
+void schedstat_enable(bool enabled);
+void schedstat_reset();
+SchedCpuStats* schedstat_of(uint32_t cpu_id);
+void schedstat_dump();
+
+void schedstat_record_switch(volatile Cpu* cpu, Task* prev, Task* next);
+void schedstat_record_timer(volatile Cpu* cpu, uint64_t start);
+
+// *Stamp a task being queued, to measure how long it waits before running
+// @param task the task being queued
+// @param woken true if the task is queued by a wakeup
+static inline void schedstat_queued(Task* task, bool woken) {
+    if (likely(!schedstat_enabled)) return;
+
+    task->stats.queued_at = read_tsc();
+    task->stats.woken = woken;
+    if (woken) task->stats.total.wakeups++;
+}
+
+// *Get the start timestamp of a measured section
+// @return the current cycle counter, or 0 if the statistics are disabled
+static inline uint64_t schedstat_begin() {
+    return (likely(!schedstat_enabled)) ? 0 : read_tsc();
+}
@@ -1,126 +1,404 @@
 #include "scheduler.h"
 #include "arch.h"
 #include "task.h"
+#include "schedstat.h"
+#include "reaper.h"
+#include "timer.h"
+#include "cputime.h"
+#include "rcu.h"
 #include "kernel/common/cpu.h"
 #include "kernel/common/kservice.h"
 #include <stdbool.h>
 #include <_null.h>
-#include <linkedlist.h>
 #include <neutrino/lock.h>
 #include <neutrino/macros.h>
 
+#ifdef __x86_64
+#include "kernel/x86_64/interrupts.h"
+#else
+#error "Unsupported platform"
+#endif
+
+Scheduler scheduler;
+
 // === PRIVATE FUNCTIONS ========================
 
-// --- CPU functions ----------------------------
+// --- Queue management -------------------------
 
-// *Get if the given CPU is currently idle
-// @param cpu the CPU to check 
-// @return true if both current and next tasks are cleared, false otherwise
-bool cpu_is_idle(volatile Cpu* cpu) {
-    return (cpu->tasks.current == nullptr || cpu->tasks.current == cpu->tasks.idle) 
-            && (cpu->tasks.next == nullptr);
+// scheduler ticks a task can run for on each priority level before being demoted
+static uint32_t sched_level_slices[TASK_PRIORITY_LEVELS] = {1, 2, 2, 4, 4, 8, 8, 16};
+
+// locked while the deadline tasks are admitted on the CPUs
+static Lock dl_lock = NewNamedLock("deadline admission");
+
+// *Get the run queue of the given CPU
+// @param cpu_id the id of the CPU
+// @return the run queue of the CPU
+static inline RunQueue* queue_of(uint32_t cpu_id) {
+    return &scheduler.queues[cpu_id];
 }
 
-// *Get it the given CPU is Next-free
-// @param cpu the CPU to check 
-// @return true if next task is cleared, false otherwise
-bool cpu_is_next_free(volatile Cpu* cpu) {
-    return (cpu->tasks.next == nullptr);
+// *Get if the given run queue is empty
+// @param queue the run queue to check
+// @return true if the run queue is empty, false otherwise
+bool queue_is_empty(RunQueue* queue) {
+    return queue->count == 0;
 }
 
-bool cpu_peek_other(volatile Cpu* cpu) {
-    ks.fatal(FatalError(NOT_IMPLEMENTED, "cpu_peek_other() not implemented."));
-    return false;
+// *Get if the given run queue has tasks with a higher priority than [level]. Deadline tasks are always higher
+// @param queue the run queue to check
+// @param level the priority level to compare with
+// @return true if a task on a higher priority level is queued, false otherwise
+static inline bool queue_has_higher(RunQueue* queue, uint8_t level) {
+    return queue->deadline.count > 0 || (queue->bitmap & ((1u << level) - 1)) != 0;
 }
 
-void cpu_swap_task(volatile Cpu* cpu) {
-    LockRetain(cpu->tasks.current->lock);
-    LockRetain(cpu->tasks.next->lock);
+// *Get if the given run queue has a deadline task with an earlier deadline than [task]
+// @param queue the run queue to check
+// @param task the running deadline task
+// @return true if the task must be preempted, false otherwise
+static inline bool queue_has_earlier(RunQueue* queue, Task* task) {
+    Task* head = queue->deadline.head;
+    return head != nullptr && head->dl.abs_deadline < task->dl.abs_deadline;
+}
 
-    if (cpu->tasks.current->status == TASK_RUNNING)
-        cpu->tasks.current->status = TASK_READY;
-    
-    // swap
-    Task* temp = cpu->tasks.current;
-    cpu->tasks.current = cpu->tasks.next;
-    cpu->tasks.next = temp;
+// *Insert a deadline task in the given run queue, ordered by absolute deadline
+// @param queue the run queue to insert the task into
+// @param task the task to be inserted
+static inline void queue_push_deadline(RunQueue* queue, Task* task) {
+    Task* before = queue->deadline.head;
+    while (before != nullptr && before->dl.abs_deadline <= task->dl.abs_deadline) before = before->queue_next;
 
-    return;
+    task_queue_insert_before(&queue->deadline, before, task);
+    queue->count++;
 }
 
-void cpu_next(volatile Cpu* cpu) {
-    LockRetain(cpu->tasks.next->lock);
+// *Append a task to the given run queue, on the level of its current priority
+// @param queue the run queue to append the task to
+// @param task the task to be appended
+void queue_push(RunQueue* queue, Task* task) {
+    TicketRetain(queue->lock);
 
-    cpu->tasks.current = cpu->tasks.next;
-    cpu->tasks.next = nullptr;
+    if (task->status == TASK_RUNNING)
+        task->status = TASK_READY;
+    if (task->sched_class == SCHED_CLASS_DEADLINE) {
+        queue_push_deadline(queue, task);
+        return;
+    }
+    if (task->priority.slice == 0)
+        task->priority.slice = sched_level_slices[task->priority.level];
 
-    return;
+    task_queue_push(&queue->levels[task->priority.level], task);
+    queue->bitmap |= (1u << task->priority.level);
+    queue->count++;
 }
 
-// --- Queue management -------------------------
+// *Remove the deadline task with the earliest deadline or, if there's none, the first task
+// *of the highest priority level from the given run queue
+// @param queue the run queue to take the task from
+// @return the task to run next, or nullptr if the queue is empty
+Task* queue_pop(RunQueue* queue) {
+    if (queue_is_empty(queue)) return nullptr;
+    TicketRetain(queue->lock);
+
+    if (queue->deadline.count > 0) {
+        queue->count--;
+        return task_queue_pop(&queue->deadline);
+    }
+
+    if (queue->bitmap == 0) return nullptr;
+
+    uint8_t level = __builtin_ctz(queue->bitmap);
+    Task* task = task_queue_pop(&queue->levels[level]);
+    if (queue->levels[level].count == 0)
+        queue->bitmap &= ~(1u << level);
+    queue->count--;
+
+    return task;
+}
+
+// *Remove a task from a level of the given run queue. The queue must be locked
+// @param queue the run queue the task is in
+// @param level the level the task is queued on
+// @param task the task to remove
+static inline void queue_remove(RunQueue* queue, uint8_t level, Task* task) {
+    task_queue_remove(&queue->levels[level], task);
+    if (queue->levels[level].count == 0)
+        queue->bitmap &= ~(1u << level);
+    queue->count--;
+}
 
-// *Get if the GTQ is empty
-// @return true if the GTQ is empty, false otherwise
-bool queue_is_empty() {
-    LockRetain(scheduler.gtq_lock) 
-    return scheduler.gtq == nullptr;
-}
-
-Task* unoptimized queue_assign(Task* task_slot, bool ignore_affinity, uint16_t cpu_id) {
-    LockRetain((scheduler.gtq_lock));
-
-    List* p = scheduler.gtq;
-    Task* t = nullptr;
-    int t_index = 0;
-
-    while (p != nullptr) {
-        t = list_get_value(p);
-        // check if task is unlocked, and acquire lock if so
-        if (t->lock.flag == UNLOCKED) {
-            LockRetain((t->lock));
-
-            // if task is runnable check for assignable
-            if (IsTaskRunnable(t)) {
-                // check for affinity
-                if (!ignore_affinity) {
-                    if (t->cpu_affinity.cpu_id != cpu_id) {
-                        if (t->cpu_affinity.affinity_ignored == false)
-                            t->cpu_affinity.affinity_ignored = true;
-                        else
-                            break;      // quit cycle, p is the task to be assigned
-                    }    
-                }
-
-                break;      // affinity is unnecessary, p is the task to be assigned
+// *Take the first task allowed to run on the given CPU from the highest priority level that has one.
+// *On the same level, tasks preferring the CPU are taken first. Tasks still switching out are skipped
+// @param queue the run queue to steal from
+// @param cpu_id the CPU the task is stolen for
+// @return the stolen task, or nullptr if every queued task is pinned to other CPUs
+Task* queue_steal(RunQueue* queue, uint32_t cpu_id) {
+    if (queue_is_empty(queue)) return nullptr;
+    TicketRetain(queue->lock);
+
+    for (uint8_t level = 0; level < TASK_PRIORITY_LEVELS; level++) {
+        if ((queue->bitmap & (1u << level)) == 0) continue;
+
+        Task* found = nullptr;
+        for (Task* task = queue->levels[level].head; task != nullptr; task = task->queue_next) {
+            if (task->on_cpu) continue;     // requeued by its CPU, which still runs on its stack
+            if (!cpu_mask_test(&task->cpu_affinity.allowed, cpu_id)) continue;
+            if (found == nullptr) found = task;
+            if (cpu_mask_test(&task->cpu_affinity.preferred, cpu_id)) {
+                found = task;
+                break;
             }
         }
-        
-        t = nullptr;
-        p = p->next;
-        t_index++;
+
+        if (found == nullptr) continue;
+
+        queue_remove(queue, level, found);
+        return found;
     }
 
-    // ! check for empty task
-    if (t == nullptr) return nullptr;
+    return nullptr;
+}
+
+// *Take a task the load balancer can move to the given CPU, starting from the last task of the lowest priority
+// *level. The task must be allowed and preferred on the CPU, and cold: tasks that ran less than [hot] cycles ago
+// *likely still have their working set in the cache of their CPU. Tasks still switching out are skipped
+// @param queue the run queue to take the task from
+// @param cpu_id the CPU the task is moved to
+// @param hot the cycles after which a task is no longer cache hot
+// @return the task to move, or nullptr if no queued task can be moved
+Task* queue_migrate(RunQueue* queue, uint32_t cpu_id, uint64_t hot) {
+    if (queue_is_empty(queue)) return nullptr;
+    uint64_t now = read_tsc();
+    TicketRetain(queue->lock);
+
+    for (int8_t level = TASK_PRIORITY_LEVELS - 1; level >= 0; level--) {
+        if ((queue->bitmap & (1u << level)) == 0) continue;
+
+        for (Task* task = queue->levels[level].tail; task != nullptr; task = task->queue_prev) {
+            if (task->on_cpu) continue;
+            if (!cpu_mask_test(&task->cpu_affinity.allowed, cpu_id)) continue;
+            if (!cpu_mask_test(&task->cpu_affinity.preferred, cpu_id)) continue;
+            if (task->cputime.last_ran != 0 && now - task->cputime.last_ran < hot) continue;
+
+            queue_remove(queue, level, task);
+            return task;
+        }
+    }
 
-    // assign task and reset affinity
-    task_slot = t;
-    task_slot->cpu_affinity.cpu_id = cpu_id;
-    task_slot->cpu_affinity.affinity_ignored = false;
+    return nullptr;
+}
 
-    // remove from gtq
-    scheduler.gtq = list_delete_at(scheduler.gtq, t_index);
+// *Move every task queued on [queue], on any level, back to its base level with a full slice of that level, so
+// *that demoted tasks can't starve. Tasks already on their base level only get their slice refilled. Tasks that
+// *are running, blocked or queued on other CPUs are not touched. Called by sched_cycle() once every
+// *SCHED_BOOST_PERIOD cycles of the CPU, which resets the level of the running task itself
+// @param queue the run queue to boost
+void queue_boost(RunQueue* queue) {
+    TicketRetain(queue->lock);
+
+    for (uint8_t level = 0; level < TASK_PRIORITY_LEVELS; level++) {
+        // demotions only increase the level, so base <= level: a task is either requeued on this level, behind
+        // the [count] tasks left to visit, or moved to a lower level the loop already went through
+        size_t count = queue->levels[level].count;
+        while (count-- > 0) {
+            Task* task = task_queue_pop(&queue->levels[level]);
+            task->priority.level = task->priority.base;
+            task->priority.slice = sched_level_slices[task->priority.level];
+
+            task_queue_push(&queue->levels[task->priority.level], task);
+            queue->bitmap |= (1u << task->priority.level);
+        }
 
-    return task_slot;
+        if (queue->levels[level].count == 0)
+            queue->bitmap &= ~(1u << level);
+    }
 }
 
-void queue_put(Task* task) {
-    LockRetain(scheduler.gtq_lock);
+// --- Priority management ----------------------
 
-    if (task->status == TASK_RUNNING)
-        task->status = TASK_READY;
+// *Lower the priority of a task that used up its whole slice
+// @param task the task to be demoted
+static inline void task_demote(Task* task) {
+    if (task->priority.level < TASK_PRIORITY_LEVELS - 1)
+        task->priority.level++;
+    task->priority.slice = sched_level_slices[task->priority.level];
+}
+
+// *Raise the priority of a task that gave up the CPU before the end of its slice
+// @param task the task to be boosted
+static inline void task_boost(Task* task) {
+    if (task->priority.level > task->priority.base)
+        task->priority.level--;
+    task->priority.slice = sched_level_slices[task->priority.level];
+}
+
+// --- Deadline class ---------------------------
+
+// *Get if a task can run on the given CPU: deadline tasks only run on the CPU they are admitted on
+// @param task the task to check
+// @param cpu_id the id of the CPU
+// @return true if the task can run on the CPU, false otherwise
+static inline bool task_can_run_on(Task* task, uint32_t cpu_id) {
+    if (task->sched_class == SCHED_CLASS_DEADLINE) return task->dl.cpu_id == cpu_id;
+    return cpu_mask_test(&task->cpu_affinity.allowed, cpu_id);
+}
+
+// *Release the next job of a deadline task, replenishing its budget. Called by the timer of the task, on its CPU.
+// *A job that wasn't completed by the release of the next one missed its deadline
+// @param timer the timer of the task
+void dl_release(Timer* timer) {
+    Task* task = (Task*)timer->data;
+    uint64_t now = read_tsc();
+
+    if (!task->dl.completed) task->dl.misses++;
+
+    // a late release, after whole periods were lost, restarts from now
+    if (task->dl.release + task->dl.period <= now) task->dl.release = now;
+
+    task->dl.budget = task->dl.runtime;
+    task->dl.abs_deadline = task->dl.release + task->dl.deadline;
+    task->dl.release += task->dl.period;
+    task->dl.completed = false;
+    if (get_current_cpu()->tasks.current == task) task->dl.last_start = now;
+
+    timer_arm_at(&task->dl.timer, task->dl.cpu_id, task->dl.release);
+
+    if (task->dl.throttled) {
+        task->dl.throttled = false;
+        sched_wake(task);
+    }
+}
+
+// *Charge a deadline task for the time it ran since it was last charged. The task is throttled until its next
+// *release when its budget runs out, or when it gives up the CPU, which completes the current job
+// @param task the deadline task leaving the CPU or keeping it
+// @param yielded true if the task gave up the CPU
+void dl_charge(Task* task, bool yielded) {
+    uint64_t now = read_tsc();
+    uint64_t used = now - task->dl.last_start;
+
+    task->dl.budget = (used < task->dl.budget) ? task->dl.budget - used : 0;
+    task->dl.last_start = now;
+    if (task->status != TASK_RUNNING) return;
+
+    if (yielded) {
+        task->dl.completed = true;
+        if (now > task->dl.abs_deadline) task->dl.misses++;
+    }
+
+    if (task->dl.budget == 0 || task->dl.completed) {
+        task->status = TASK_BLOCKED;
+        task->dl.throttled = true;
+    }
+}
+
+// *Move a task out of the deadline class, giving its bandwidth back. Must be called on the CPU of the task,
+// *with interrupts disabled, so that its timer can't be running
+// @param task the deadline task
+void dl_leave(Task* task) {
+    timer_cancel(&task->dl.timer);
+    LockOperation(dl_lock, queue_of(task->dl.cpu_id)->dl_bandwidth -= task->dl.bandwidth);
+
+    task->sched_class = SCHED_CLASS_NORMAL;
+    task->dl.throttled = false;
+}
+
+// --- CPU functions ----------------------------
+
+// *Get if the given CPU is currently idle
+// @param cpu the CPU to check 
+// @return true if the CPU has no task or is running its idle task, false otherwise
+bool cpu_is_idle(volatile Cpu* cpu) {
+    return (cpu->tasks.current == nullptr || cpu->tasks.current == cpu->tasks.idle);
+}
+
+// *Steal a task from the busiest run queue of the other CPUs, or from any other queue if every task
+// *of the busiest one is pinned elsewhere
+// @param cpu the CPU looking for work
+// @return the stolen task, or nullptr if no other queue has a task allowed on the CPU
+Task* cpu_peek_other(volatile Cpu* cpu) {
+    RunQueue* busiest = nullptr;
+    size_t busiest_count = 0;
+
+    for (size_t i = 0; i < get_cpu_count(); i++) {
+        if (i == cpu->id) continue;
+
+        RunQueue* queue = queue_of(i);
+        if (queue->count > busiest_count) {
+            busiest = queue;
+            busiest_count = queue->count;
+        }
+    }
 
-    scheduler.gtq = list_append(scheduler.gtq, task);
+    if (busiest == nullptr) return nullptr;
+
+    Task* task = queue_steal(busiest, cpu->id);
+    for (size_t i = 0; i < get_cpu_count() && task == nullptr; i++) {
+        RunQueue* queue = queue_of(i);
+        if (i != cpu->id && queue != busiest) task = queue_steal(queue, cpu->id);
+    }
+
+    return task;
+}
+
+// *Pull tasks from the busiest CPU, when its load average exceeds the one of this CPU by more than a task.
+// *Half the difference between the queued tasks is moved, so that the two CPUs end up even
+// @param cpu the CPU running the balancer
+void cpu_balance(volatile Cpu* cpu) {
+    RunQueue* queue = queue_of(cpu->id);
+    uint64_t local = cputime_of(cpu->id)->load[0];
+    uint32_t busiest = cpu->id;
+    uint64_t busiest_load = local + LOAD_FIXED_1;
+
+    for (uint32_t i = 0; i < get_cpu_count(); i++) {
+        uint64_t load = cputime_of(i)->load[0];
+        if (i != cpu->id && load > busiest_load && queue_of(i)->count > queue->count) {
+            busiest = i;
+            busiest_load = load;
+        }
+    }
+
+    if (busiest == cpu->id) return;
+
+    size_t moves = Min((queue_of(busiest)->count - queue->count) / 2, SCHED_BALANCE_MAX);
+    uint64_t hot = arch_ns_to_cycles(SCHED_CACHE_HOT);
+
+    for (size_t i = 0; i < moves; i++) {
+        Task* task = queue_migrate(queue_of(busiest), cpu->id, hot);
+        if (task == nullptr) break;
+
+        schedstat_queued(task, false);
+        queue_push(queue, task);
+    }
+}
+
+// *Choose the CPU a task is queued on. The last CPU is kept while allowed and preferred, since its cache
+// *is likely still warm. Otherwise the least loaded preferred CPU is chosen, then the least loaded allowed one
+// @param task the task to place
+// @return the id of the chosen CPU
+uint32_t cpu_select(Task* task) {
+    if (task->sched_class == SCHED_CLASS_DEADLINE) return task->dl.cpu_id;
+
+    uint32_t last = task->cpu_affinity.cpu_id;
+    if (last < get_cpu_count() && cpu_mask_test(&task->cpu_affinity.allowed, last) 
+        && cpu_mask_test(&task->cpu_affinity.preferred, last)) return last;
+
+    CpuMask preferred = cpu_mask_and(&task->cpu_affinity.allowed, &task->cpu_affinity.preferred);
+    const CpuMask* masks[] = {&preferred, &task->cpu_affinity.allowed};
+
+    for (size_t i = 0; i < 2; i++) {
+        uint32_t best = MAX_CPU;
+        for (uint32_t id = 0; id < get_cpu_count(); id++) {
+            if (!cpu_mask_test(masks[i], id)) continue;
+            if (best == MAX_CPU || queue_of(id)->count < queue_of(best)->count) best = id;
+        }
+
+        if (best != MAX_CPU) return best;
+    }
+
+    // the mask was validated when set, it can only be empty for CPUs that never came online
+    return get_current_cpu()->id;
 }
 
 // --- Scheduler default tasks ------------------
@@ -129,91 +407,446 @@ void cpu_idle() {
     arch_idle();
 }
 
+// *Stop the periodic tick of a CPU with nothing to switch to, or restore it when there's work to share.
+// *A tickless CPU wakes up for its first timer, or after SCHED_TICKLESS_MAX to look for work to steal
+// @param cpu the CPU to update
+void cpu_update_tick(volatile Cpu* cpu) {
+    bool tickless = queue_is_empty(queue_of(cpu->id));
+
+    if (tickless) {
+        uint64_t ms = SCHED_TICKLESS_MAX;
+        uint64_t deadline = timer_next_deadline(cpu->id), now = read_tsc();
+        if (deadline != 0) ms = (deadline > now) ? Min(ms, arch_cycles_to_ms(deadline - now)) : 1;
+
+        // a deadline task must be throttled as soon as its budget runs out
+        Task* current = cpu->tasks.current;
+        if (current != nullptr && current->sched_class == SCHED_CLASS_DEADLINE)
+            ms = Max(Min(ms, arch_cycles_to_ms(current->dl.budget)), 1);
+
+        arch_timer_oneshot(ms);
+    } else if (cpu->tasks.tickless) {
+        arch_timer_periodic();
+    }
+
+    cpu->tasks.tickless = tickless;
+}
+
 // === PUBLIC FUNCTIONS =========================
 
-void unoptimized init_scheduler() {
+void init_scheduler() {
     ks.log("Initializing scheduler...");
     scheduler.ready = false;
 
     for (size_t i = 0; i < get_cpu_count(); i++) {
         volatile Cpu* cpu = get_cpu(i);
         cpu->tasks.idle = NewIdleTask((uintptr_t)cpu_idle);
+        cpu->tasks.idle->cpu_affinity.cpu_id = i;
+        cpu->tasks.idle->cpu_affinity.allowed = NewCpuMask;
+        cpu_mask_set(&cpu->tasks.idle->cpu_affinity.allowed, i);
         cpu->tasks.is_switching = NewLock;
+        cpu->tasks.tickless = false;
+        cpu->tasks.preempt_count = 0;
+        cpu->tasks.need_resched = cpu->tasks.polling = false;
+        cpu->tasks.reaper = nullptr;
+        cpu->tasks.zombies = NewTaskQueue;
+
+        RunQueue* queue = queue_of(i);
+        *queue = (RunQueue){.lock = NewNamedTicketLock("run queue"), .bitmap = 0, .count = 0, .ticks = 0, .dl_bandwidth = 0};
+        queue->deadline = NewTaskQueue;
+        for (size_t level = 0; level < TASK_PRIORITY_LEVELS; level++)
+            queue->levels[level] = NewTaskQueue;
     }
 
-    scheduler.gtq = nullptr;
-    scheduler.gtq_lock = NewLock;
+    for (size_t i = 0; i < get_cpu_count(); i++)
+        init_reaper(get_cpu(i));
 
     ks.log("Scheduler initialized");
-    scheduler.ready = true;
+    __atomic_store_n(&scheduler.ready, true, __ATOMIC_RELEASE);
 }
 
-void sched_start(Task* task, uintptr_t entry_point) {
+// *Prepare the context of a task that never ran and queue it
+// @param task the task to start
+// @param entry_point the function run by the task
+// @param argument the first argument given to the function
+void sched_launch(Task* task, uintptr_t entry_point, uintptr_t argument) {
     LockRetain(task->lock);
-    context_init(task->context, entry_point, PROCESS_STACK_BASE + PROCESS_STACK_SIZE - sizeof(uintptr_t), 
-                PROCESS_STACK_BASE + PROCESS_STACK_SIZE - sizeof(uintptr_t), (ContextFlags){.user = task->user});
+    context_init(task->context, entry_point, TaskStackTop(task), TaskKernelStackTop(task), 
+                (ContextFlags){.user = task->user});
+    context_set_argument(task->context, argument);
     task->status = TASK_NEW;
+    task->cpu_affinity.cpu_id = get_current_cpu()->id;
 
-    queue_put(task);
+    reaper_track(task);
+    sched_wake(task);
 }
 
-void unoptimized sched_cycle(volatile Cpu* cpu) {
-    if (cpu->tasks.current != nullptr) {
-        if (cpu->tasks.current->status == TASK_ZOMBIE) {
-            DestroyTask(cpu->tasks.current);
-            cpu->tasks.current = nullptr;
+void sched_start(Task* task, uintptr_t entry_point) {
+    sched_launch(task, entry_point, 0);
+}
+
+// *Start a thread created by NewThread()
+// @param thread the thread to start
+// @param entry_point the function run by the thread
+// @param argument the argument given to the function
+void sched_start_thread(Task* thread, uintptr_t entry_point, uintptr_t argument) {
+    sched_launch(thread, entry_point, argument);
+}
+
+// *Make a task runnable, queueing it on the CPU chosen by its affinity, usually the one it last ran on.
+// *Tasks woken up after waiting are boosted, since they're likely interactive or I/O-bound
+// @param task the task to be queued
+void sched_wake(Task* task) {
+    bool enabled = interrupts_save();
+    uint32_t cpu_id = cpu_select(task);
+
+    // a task blocking on another CPU may still be switching out: its context must be saved before queueing it
+    while (task->on_cpu) asm volatile ("pause" ::: "memory");
+
+    if (task->status == TASK_BLOCKED) {
+        task->status = TASK_READY;
+        task_boost(task);
+        schedstat_queued(task, true);
+    } else {
+        schedstat_queued(task, false);
+    }
+
+    queue_push(queue_of(cpu_id), task);
+
+    // a tickless CPU would only notice the task on its next one-shot interrupt, an idle one on its next tick
+    volatile Cpu* cpu = get_current_cpu();
+    volatile Cpu* target = get_cpu(cpu_id);
+    if (cpu_id == cpu->id && cpu->tasks.tickless) {
+        cpu->tasks.tickless = false;
+        arch_timer_periodic();
+    } else if (cpu_id != cpu->id && (target->tasks.tickless || cpu_is_idle(target))) {
+        cpu_kick(cpu_id);
+    }
+
+    interrupts_restore(enabled);
+}
+
+// *Give up the CPU, switching to the next task. The current task is queued again behind the tasks
+// *of its priority level, unless it's blocked
+void sched_yield() {
+    Task* task = get_current_task();
+    if (task != nullptr) task->yielded = true;
+
+    arch_yield();
+}
+
+// *Wake up a task sleeping in sched_sleep()
+// @param timer the timer of the sleeping task
+void sched_sleep_expired(Timer* timer) {
+    sched_wake((Task*)timer->data);
+}
+
+// *Block the current task for [ns] nanoseconds at least. The task is woken up by a timer of the CPU,
+// *which is kept in the task stack while sleeping
+// @param ns the sleep duration, in nanoseconds
+void sched_sleep(uint64_t ns) {
+    bool enabled = interrupts_save();
+    Task* task = get_current_task();
+    Timer timer = NewTimer(sched_sleep_expired, task);
+
+    // the timer can't expire before the task is blocked, since interrupts are disabled
+    task->status = TASK_BLOCKED;
+    timer_arm(&timer, ns);
+    sched_yield();
+
+    interrupts_restore(enabled);
+}
+
+// *Set the base priority level of a task. The current level of a queued task is updated on the next boost
+// @param task the task to update
+// @param priority the new base priority level, 0 being the highest
+// @return false if the priority level is not valid, true otherwise
+bool sched_set_priority(Task* task, uint8_t priority) {
+    if (priority >= TASK_PRIORITY_LEVELS) return false;
+    LockRetain(task->lock);
+
+    task->priority.base = priority;
+    if (task->status != TASK_READY) {
+        task->priority.level = priority;
+        task->priority.slice = sched_level_slices[priority];
+    }
+
+    return true;
+}
+
+// *Set the CPUs a task can run on. A running task leaves a CPU removed from its mask on the next cycle
+// @param task the task to update
+// @param allowed the hard affinity, CPUs that are not online are ignored
+// @param preferred the soft affinity, restricted to the allowed CPUs. An empty mask means no preference
+// @return false if no allowed CPU is online, true otherwise
+bool sched_set_affinity(Task* task, CpuMask allowed, CpuMask preferred) {
+    CpuMask online = cpu_mask_first(get_cpu_count());
+    allowed = cpu_mask_and(&allowed, &online);
+    if (cpu_mask_is_empty(&allowed)) return false;
+
+    preferred = cpu_mask_and(&preferred, &allowed);
+    if (cpu_mask_is_empty(&preferred)) preferred = allowed;
+
+    LockRetain(task->lock);
+    task->cpu_affinity.allowed = allowed;
+    task->cpu_affinity.preferred = preferred;
+
+    return true;
+}
+
+// *Move the current task to the deadline class: a job of [runtime] cycles is released every [period] cycles,
+// *and must be completed [deadline] cycles after its release. The task is admitted on the first allowed CPU,
+// *starting from the current one, with enough free bandwidth. It's then pinned there until it leaves the class
+// @param task the current task
+// @param runtime the budget of every job, 0 to move the task back to the normal class
+// @param deadline the relative deadline of every job, between runtime and period
+// @param period the time between two job releases
+// @return false if the parameters are not valid, if no CPU can admit the task or if the task is still
+// @return moving to the CPU it was admitted on, true otherwise
+bool sched_set_deadline(Task* task, uint64_t runtime, uint64_t deadline, uint64_t period) {
+    if (runtime != 0 && (runtime > deadline || deadline > period)) return false;
+
+    // the task is reconfigured on its own CPU, with interrupts disabled, so that its release timer can't run
+    bool enabled = interrupts_save();
+    volatile Cpu* cpu = get_current_cpu();
+    if (task->sched_class == SCHED_CLASS_DEADLINE) {
+        if (task->dl.cpu_id != cpu->id) {
+            interrupts_restore(enabled);
+            return false;
         }
+
+        dl_leave(task);
+    }
+
+    if (runtime == 0) {
+        interrupts_restore(enabled);
+        return true;
+    }
+
+    uint64_t bandwidth = runtime * SCHED_DL_UNIT / period;
+    uint32_t target = MAX_CPU;
+
+    lock(&dl_lock);
+    for (uint32_t i = 0; i < get_cpu_count() && target == MAX_CPU; i++) {
+        uint32_t id = (cpu->id + i) % get_cpu_count();
+        if (cpu_mask_test(&task->cpu_affinity.allowed, id) 
+            && queue_of(id)->dl_bandwidth + bandwidth <= SCHED_DL_MAX_BANDWIDTH) target = id;
+    }
+
+    if (target != MAX_CPU) queue_of(target)->dl_bandwidth += bandwidth;
+    unlock(&dl_lock);
+
+    if (target == MAX_CPU) {
+        interrupts_restore(enabled);
+        return false;
     }
 
-    if (cpu_is_idle(cpu)) {
-        if (queue_is_empty()) {                         
-            // if cpu is idle and queue is empty, try peeking from other cpus. 
-            // cpu_peek_other(cpu); // todo when implementing multi-core
-        } else {                                        
-            // if the cpu is idle but the GTQ has something pending, assign to cpu from the queue.
-            cpu->tasks.current = queue_assign(cpu->tasks.current, true, cpu->id);
+    uint64_t now = read_tsc();
+    task->dl.runtime = runtime;
+    task->dl.deadline = deadline;
+    task->dl.period = period;
+    task->dl.bandwidth = bandwidth;
+    task->dl.budget = runtime;
+    task->dl.abs_deadline = now + deadline;
+    task->dl.release = now + period;
+    task->dl.last_start = now;
+    task->dl.cpu_id = target;
+    task->dl.throttled = false;
+    task->dl.completed = false;
+    task->dl.timer = NewTimer(dl_release, task);
+    task->sched_class = SCHED_CLASS_DEADLINE;
+
+    // a task admitted elsewhere arms its timer once switched in on its CPU, the next cycle moves it there
+    if (target == cpu->id) timer_arm_at(&task->dl.timer, target, task->dl.release);
+
+    interrupts_restore(enabled);
+    return true;
+}
+
+// *Set the number of scheduler ticks a task can run for on the given priority level
+// @param level the priority level to update
+// @param ticks the length of the slice, in scheduler ticks
+// @return false if the level or the slice length is not valid, true otherwise
+bool sched_set_level_slice(uint8_t level, uint32_t ticks) {
+    if (level >= TASK_PRIORITY_LEVELS || ticks == 0) return false;
+
+    sched_level_slices[level] = ticks;
+    return true;
+}
+
+void sched_cycle(volatile Cpu* cpu) {
+    Task* prev = cpu->tasks.current;
+    Task* current = prev;
+    RunQueue* queue = queue_of(cpu->id);
+
+    bool yielded = (prev != nullptr && prev->yielded);
+    if (prev != nullptr) prev->yielded = false;
+
+    cpu->tasks.need_resched = false;
+    rcu_quiescent(cpu);
+    cputime_charge(cpu, prev);
+    cputime_sample(cpu, queue->count + !cpu_is_idle(cpu));
+
+    // the current task keeps on_cpu set until sched_finish_switch(): the CPU still runs on its kernel stack
+    // terminated tasks are destroyed by the reaper, out of the interrupt handler
+    if (prev != nullptr && prev->status == TASK_ZOMBIE) {
+        if (prev->sched_class == SCHED_CLASS_DEADLINE) dl_leave(prev);
+        reaper_collect(cpu, prev);
+        prev = nullptr;
+    }
+
+    // deadline tasks are charged for the time they ran, and throttled once out of budget
+    if (prev != nullptr && prev->sched_class == SCHED_CLASS_DEADLINE && task_can_run_on(prev, cpu->id))
+        dl_charge(prev, yielded);
+
+    // blocked tasks are queued again only when woken up
+    if (prev == cpu->tasks.idle || (prev != nullptr && prev->status == TASK_BLOCKED)) prev = nullptr;
+
+    // the affinity of the task changed while running, it's moved to one of its allowed CPUs once switched out
+    if (prev != nullptr && !task_can_run_on(prev, cpu->id)) {
+        cpu->tasks.prev_moved = true;
+        prev = nullptr;
+    }
+
+    if (++queue->ticks % SCHED_BOOST_PERIOD == 0) {
+        queue_boost(queue);
+        if (prev != nullptr) prev->priority.level = prev->priority.base;
+    }
+
+    if (queue->ticks % SCHED_BALANCE_PERIOD == 0) cpu_balance(cpu);
+
+    // a deadline task keeps running until a task with an earlier deadline is released
+    if (prev != nullptr && prev->sched_class == SCHED_CLASS_DEADLINE) {
+        if (!queue_has_earlier(queue, prev)) {
+            prev->status = TASK_RUNNING;
+            cpu_update_tick(cpu);
+            return;
         }
-    } else {
-        if (queue_is_empty()) {
-            if (!cpu_is_next_free(cpu)) {
-                // if the cpu is busy, the GTQ is empty and the next slot is filled, then swap current and next.
-                if (cpu->tasks.current == nullptr)
-                    cpu_next(cpu);
-                else
-                    cpu_swap_task(cpu);
-            }
-            
-        } else {
-            // if the cpu is busy and the GTQ has something pending move current task to GTQ
-            if (cpu->tasks.current != nullptr)
-                queue_put(cpu->tasks.current);
-
-            if (cpu_is_next_free(cpu)) 
-                // if the next slot is free assign the current
-                cpu->tasks.current = queue_assign(cpu->tasks.current, true, cpu->id);
-            else 
-                // if the next slot is filled put the next in the current slot
-                cpu_next(cpu);
-            
-            // try to assign the next
-            cpu->tasks.next = queue_assign(cpu->tasks.next, false, cpu->id);
+    } else if (prev != nullptr) {
+        // CPU hogs using up their whole slice are demoted. Otherwise, the task keeps running
+        // until the end of its slice, unless a task with a higher priority is waiting
+        if (prev->priority.slice > 0) prev->priority.slice--;
+
+        if (prev->priority.slice == 0) task_demote(prev);
+        else if (!yielded && !queue_has_higher(queue, prev->priority.level)) {
+            prev->status = TASK_RUNNING;
+            cpu_update_tick(cpu);
+            return;
         }
     }
 
-    // if current task is empty, it becomes an idle task
-    if (cpu->tasks.current == nullptr) 
-        cpu->tasks.current = cpu->tasks.idle;
+    // requeue the current task behind the others of its level, then take the highest priority task.
+    // If the CPU would otherwise be idle, steal from the busiest queue
+    if (prev != nullptr) {
+        schedstat_queued(prev, false);
+        queue_push(queue, prev);
+    }
+
+    Task* next = queue_pop(queue);
+    while (next != nullptr && !task_can_run_on(next, cpu->id)) {
+        sched_wake(next);       // the affinity changed while the task was queued
+        next = queue_pop(queue);
+    }
+
+    if (next == nullptr) next = cpu_peek_other(cpu);
+    if (next == nullptr) next = cpu->tasks.idle;
+
+    next->cpu_affinity.cpu_id = cpu->id;
+    next->status = TASK_RUNNING;
+    next->on_cpu = true;
+    cpu->tasks.current = next;
+    if (current != next) cpu->tasks.prev = current;
+
+    // the budget is charged from now on. Tasks admitted on another CPU release their first job once here
+    if (next->sched_class == SCHED_CLASS_DEADLINE) {
+        next->dl.last_start = read_tsc();
+        if (next->dl.timer.cpu_id < 0) timer_arm_at(&next->dl.timer, cpu->id, next->dl.release);
+    }
+
+    schedstat_record_switch(cpu, current, next);
+
+    cpu_update_tick(cpu);
+}
+
+// *Hand the task switched out by the last cycle over to the other CPUs. Called by the interrupt handler once
+// *the CPU runs on the stack of the next task: until then, the previous task can't be resumed anywhere else
+void sched_finish_switch() {
+    if (!scheduler.ready) return;
+
+    volatile Cpu* cpu = get_current_cpu();
+    Task* prev = cpu->tasks.prev;
+    if (prev == nullptr) return;
+
+    cpu->tasks.prev = nullptr;
+    __atomic_store_n(&prev->on_cpu, false, __ATOMIC_RELEASE);
+
+    if (cpu->tasks.prev_moved) {
+        cpu->tasks.prev_moved = false;
+        sched_wake(prev);
+    }
+}
+
+// *Handle a kick from another CPU that queued a task here. Unlike a tick, it charges no slice: an idle CPU
+// *switches at once, a busy one leaves tickless mode so that the queued task gets the CPU on a later tick
+// @param cpu the current CPU
+// @return true if the caller must switch to the next task now, false otherwise
+bool sched_kick(volatile Cpu* cpu) {
+    if (!preempt_enabled(cpu)) return false;    // need_resched is set, preempt_enable() switches
+    if (cpu->tasks.current == cpu->tasks.idle) return true;
 
-    cpu->tasks.current->status = TASK_RUNNING;
-    return;
+    cpu->tasks.need_resched = false;
+    cpu_update_tick(cpu);
+    return false;
 }
 
-void unoptimized sched_terminate() {
+// *Terminate the current task. It's handed to the reaper of the CPU on the next cycle, which never returns here
+// @param status the exit status, collected by the parent of the task
+void sched_exit(uint32_t status) {
     disable_interrupts();
     Cpu* cpu = get_current_cpu();
-    LockOperation(cpu->tasks.current->lock, cpu->tasks.current->status = TASK_ZOMBIE);
+    Task* task = cpu->tasks.current;
+    LockOperation(task->lock, {
+        task->exit_status = status;
+        task->status = TASK_ZOMBIE;
+    });
     // ks.log("Task ID %d (%c) on CPU %d terminated.", 
     //         cpu->tasks.current->pid, cpu->tasks.current->name, cpu->id);
-    enable_interrupts();
-    arch_idle();
+    sched_yield();
+}
+
+// *Terminate the current task successfully. Tasks return here from their entry point
+void sched_terminate() {
+    sched_exit(QUIT_SUCCESS);
+}
+
+// --- Preemption -------------------------------
+
+// *Keep the current task on its CPU until preempt_enable(). Ticks falling meanwhile are deferred, not dropped.
+// *Calls can be nested, the task must not block before enabling the preemption again. Nothing is preempted
+// *before the scheduler starts, the CPUs may not be reachable yet
+void preempt_disable() {
+    if (!scheduler.ready) return;
+    bool enabled = interrupts_save();
+    get_current_cpu()->tasks.preempt_count++;
+    interrupts_restore(enabled);
+}
+
+// *Allow the current task to be preempted again, switching to the next task at once if a tick was deferred
+void preempt_enable() {
+    if (!scheduler.ready) return;
+    bool enabled = interrupts_save();
+    volatile Cpu* cpu = get_current_cpu();
+
+    // locks taken while the scheduler was starting are released with a zero count
+    bool resched = (cpu->tasks.preempt_count > 0) && (--cpu->tasks.preempt_count == 0) && cpu->tasks.need_resched;
+    interrupts_restore(enabled);
+
+    // with interrupts disabled the switch can't happen here, it's left to the next tick
+    if (resched && enabled) arch_yield();
+}
+
+// *Get if the task running on a CPU can be preempted
+// @param cpu the CPU
+// @return false if the preemption was disabled with preempt_disable(), true otherwise
+bool preempt_enabled(volatile Cpu* cpu) {
+    return cpu->tasks.preempt_count == 0;
 }
@@ -3,24 +3,51 @@
 #include "task.h"
 #include "../cpu.h"
 #include <_null.h>
-#include <linkedlist.h>
 #include <neutrino/lock.h>
 #include <neutrino/macros.h>
 
-typedef union __global_task_queue_node {
-    Task* task;
-    union __global_task_queue_node* next;
-} packed GlobalTaskQueueNode;
+#define SCHED_BOOST_PERIOD  1000    // scheduler cycles of a CPU between two priority boosts of its queued tasks
+#define SCHED_TICKLESS_MAX  100     // longest sleep (in ms) of a tickless CPU before checking for work to steal
+#define SCHED_BALANCE_PERIOD    100     // ticks between two load balancing passes of a CPU
+#define SCHED_BALANCE_MAX       4       // tasks moved by a load balancing pass
+#define SCHED_CACHE_HOT         500000  // ns after running during which a task isn't moved by the load balancer
+
+#define SCHED_DL_UNIT           (1ull << 20)                // bandwidth of a whole CPU, in fixed point
+#define SCHED_DL_MAX_BANDWIDTH  (SCHED_DL_UNIT * 95 / 100)  // deadline tasks can't reserve more, normal tasks keep the rest
+
+typedef struct __run_queue {
+    TicketLock lock;                // locked when the owner CPU or a stealing CPU is accessing the queue
+    uint32_t bitmap;                // bit n is set when the level n queue is not empty
+    TaskQueue levels[TASK_PRIORITY_LEVELS];
+    TaskQueue deadline;             // runnable deadline tasks, sorted by absolute deadline
+    volatile size_t count;          // number of queued tasks, readable without the lock as a load hint
+    uint64_t ticks;
+    uint64_t dl_bandwidth;          // bandwidth admitted for the deadline tasks of the CPU
+} RunQueue;
 
 typedef struct __scheduler {
-    bool ready;
-    List* gtq;
-    Lock gtq_lock;                  // locked when a CPU is accessing the GTQ
+    volatile bool ready;            // set once every CPU has its run queue, read by the other CPUs
+    RunQueue queues[MAX_CPU];       // one run queue for each CPU, indexed by CPU id
 } Scheduler;
 
-Scheduler scheduler;
+extern Scheduler scheduler;
 
 void sched_cycle(volatile Cpu* cpu);
+void sched_finish_switch();
+bool sched_kick(volatile Cpu* cpu);
 void sched_start(Task* task, uintptr_t entry_point);
+void sched_start_thread(Task* thread, uintptr_t entry_point, uintptr_t argument);
+void sched_wake(Task* task);
+void sched_yield();
+void sched_sleep(uint64_t ns);
+bool sched_set_priority(Task* task, uint8_t priority);
+bool sched_set_level_slice(uint8_t level, uint32_t ticks);
+bool sched_set_affinity(Task* task, CpuMask allowed, CpuMask preferred);
+bool sched_set_deadline(Task* task, uint64_t runtime, uint64_t deadline, uint64_t period);
 void init_scheduler();
-void sched_terminate();
\ No newline at end of file
+void sched_exit(uint32_t status);
+void sched_terminate();
+
+void preempt_disable();
+void preempt_enable();
+bool preempt_enabled(volatile Cpu* cpu);
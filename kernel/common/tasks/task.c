@@ -5,13 +5,13 @@
 #include "../kservice.h"
 #include "../memory/memory.h"
 #include "../memory/space.h"
+#include "cputime.h"
+#include "pid.h"
 #include <liballoc.h>
 #include <string.h>
 #include <stdbool.h>
 #include <neutrino/macros.h>
 
-static uint32_t _global_pid = 0;
-
 // === PRIVATE FUNCTIONS ========================
 
 void task_set_name(Task* task, char* name) {
@@ -26,41 +26,147 @@ void task_set_name(Task* task, char* name) {
     }
 }
 
-// === PUBLIC FUNCTIONS =========================
+// *Fill the public information of a task
+// @param task the task to describe
+// @param info the information to fill
+void task_fill_info(Task* task, TaskInfo* info) {
+    info->pid = task->pid;
+    info->parent_pid = task->parent_pid;
+    info->status = task->status;
+    info->sched_class = task->sched_class;
+    info->cpu_id = task->cpu_affinity.cpu_id;
+    info->priority = task->priority.level;
+    info->user = task->user;
+    memory_copy((uint8_t*)task->name, (uint8_t*)info->name, Min(TASK_NAME_MAX, TASK_INFO_NAME_MAX));
+    info->name[Min(TASK_NAME_MAX, TASK_INFO_NAME_MAX)] = '\0';
+}
+
+// *Copy a task into the next entry of a task list
+// @param task the visited task
+// @param data the TaskInfoCollector being filled
+// @return false once the entries are filled
+bool task_collect_info(Task* task, void* data) {
+    TaskInfoCollector* collector = (TaskInfoCollector*)data;
+    if (collector->filled >= collector->count) return false;
+
+    task_fill_info(task, &collector->infos[collector->filled++]);
+    return true;
+}
+
+// *Allocate a task and initialize everything but its stack
+// @param name the name of the task
+// @param user true if the task runs in user mode
+// @param space the address space of the task, released if the task can't be created
+// @param channel the IPC channel of the task, released if the task can't be created
+// @return the new task, or nullptr if no pid or no memory for its kernel stack is free
+Task* task_new(char* name, bool user, Space* space, Channel* channel) {
+    uint32_t pid = pid_alloc();
+    if (pid == TASK_PID_NONE) {
+        ks.err("No free pid for task \"%c\"", name);
+        DestroyChannel(channel);
+        DestroySpace(space);
+        return nullptr;
+    }
 
-Task* unoptimized NewTask(char* name, bool user) {
     Task* task = (Task*)kmalloc(sizeof(Task));
 
     task_set_name(task, name);
 
-    task->pid = _global_pid++;
+    task->pid = pid;
+    task->parent_pid = (get_current_task() != nullptr) ? get_current_task()->pid : TASK_PID_NONE;
+    task->exit_status = QUIT_SUCCESS;
     task->status = TASK_EMBRYO;
+    task->priority.base = task->priority.level = TASK_PRIORITY_DEFAULT;
+    task->priority.slice = 0;
+    task->sched_class = SCHED_CLASS_NORMAL;
+    memory_set((uint8_t*)&task->dl, 0, sizeof(task->dl));
     task->user = user;
     task->lock = NewLock;
-    task->space = NewSpace();
+    task->space = space;
     task->context = NewContext();
-    task->channel = NewChannel(CHANNEL_CAN_RECEIVE | CHANNEL_CAN_SEND, name);
+    task->channel = channel;
 
     task->in_io = false;
     task->in_syscall = false;
+    task->on_cpu = false;
+    task->yielded = false;
+    task->queue_next = task->queue_prev = nullptr;
+    task->cpu_affinity.cpu_id = 0;
+    task->cpu_affinity.allowed = task->cpu_affinity.preferred = cpu_mask_first(CPU_MASK_BITS);
+    memory_set((uint8_t*)&task->stats, 0, sizeof(task->stats));
+    memory_set((uint8_t*)&task->cputime, 0, sizeof(task->cputime));
+
+    task->kernel_stack = memory_allocate_large(TASK_KSTACK_SIZE / PAGE_SIZE);
+    if (task->kernel_stack == nullptr) {
+        ks.err("No memory for the kernel stack of task \"%c\"", name);
+        DestroyContext(task->context);
+        kfree(task);
+        pid_free(pid);
+        DestroyChannel(channel);
+        DestroySpace(space);
+        return nullptr;
+    }
+
+    pid_publish(pid, task);
+    return task;
+}
+
+// === PUBLIC FUNCTIONS =========================
 
+Task* NewTask(char* name, bool user) {
+    Task* task = task_new(name, user, NewSpace(), NewChannel(CHANNEL_CAN_RECEIVE | CHANNEL_CAN_SEND, name));
+    if (task == nullptr) return nullptr;
+
+    task->stack_virt = PROCESS_STACK_BASE;
+    task->stack_slot = -1;
     task_set_stack(task, user);
     return task;
 }
 
-Task* unoptimized NewIdleTask(uintptr_t entry_point) {
+// *Create a thread of [process], sharing its space and channel. The thread gets its own stacks and context,
+// *and inherits the priority and the affinity of the process
+// @param process the task the thread belongs to
+// @return the new thread, or nullptr if the space has no free thread stack slot or no pid is free
+Task* NewThread(Task* process) {
+    Task* thread = task_new(process->name, process->user, space_retain(process->space), channel_retain(process->channel));
+    if (thread == nullptr) return nullptr;
+
+    thread->priority.base = thread->priority.level = process->priority.base;
+    thread->cpu_affinity.allowed = process->cpu_affinity.allowed;
+    thread->cpu_affinity.preferred = process->cpu_affinity.preferred;
+
+    thread->stack_slot = -1;
+    if (!task_set_thread_stack(thread, process->user)) {
+        // nobody can wait for a thread that never started, its pid is freed at once
+        uint32_t pid = thread->pid;
+        DestroyTask(thread);
+        pid_free(pid);
+        return nullptr;
+    }
+
+    return thread;
+}
+
+Task* NewIdleTask(uintptr_t entry_point) {
     Task* idle = NewTask("idle", false);
-    context_init(idle->context, entry_point, PROCESS_STACK_BASE + PROCESS_STACK_SIZE, PROCESS_STACK_BASE, (ContextFlags){0});
+    context_init(idle->context, entry_point, PROCESS_STACK_BASE + PROCESS_STACK_SIZE, TaskKernelStackTop(idle), (ContextFlags){0});
 
     idle->status = TASK_NEW;
 
     return idle;
 }
 
+// *Free a task. Its pid stays allocated until its exit status is collected
+// @param task the task to destroy
 void DestroyTask(Task* task) {
+    pid_unlink(task->pid);
+    pid_synchronize();
+
+    if (task->stack_slot >= 0) task_free_thread_stack(task);
     DestroyChannel(task->channel);
     DestroyContext(task->context);
     DestroySpace(task->space);
+    memory_free_large(task->kernel_stack, TASK_KSTACK_SIZE / PAGE_SIZE);
     kfree(task);
 }
 
@@ -68,10 +174,95 @@ Task* get_current_task() {
     return get_current_cpu()->tasks.current;
 }
 
+// *Get the information of the task with the given pid
+// @param pid the pid of the task
+// @param info the information to fill
+// @return false if no task has the pid, true otherwise
+bool task_info(uint32_t pid, TaskInfo* info) {
+    bool enabled = pid_read_begin();
+    Task* task = pid_lookup(pid);
+    if (task != nullptr) task_fill_info(task, info);
+    pid_read_end(enabled);
+
+    return task != nullptr;
+}
+
+// *List the tasks in pid order, starting from a pid, so that the list can be read in several calls
+// @param from the first pid to list
+// @param infos the entries to fill
+// @param count the number of entries available
+// @return the number of filled entries
+size_t task_list(uint32_t from, TaskInfo* infos, size_t count) {
+    TaskInfoCollector collector = {.infos = infos, .count = count, .filled = 0};
+    if (count > 0) pid_foreach(from, task_collect_info, &collector);
+
+    return collector.filled;
+}
+
 void task_start_syscall() {
-    get_current_task()->in_syscall = true;
+    cputime_syscall(true);
 }
 
 void task_end_syscall() {
-    get_current_task()->in_syscall = false;
+    cputime_syscall(false);
+}
+
+// --- Task queues ------------------------------
+
+// *Append a task to the tail of a queue. The task must not be in any other queue
+// @param queue the queue to append the task to
+// @param task the task to be appended
+void task_queue_push(TaskQueue* queue, Task* task) {
+    task->queue_next = nullptr;
+    task->queue_prev = queue->tail;
+
+    if (queue->tail != nullptr) queue->tail->queue_next = task;
+    else queue->head = task;
+
+    queue->tail = task;
+    queue->count++;
+}
+
+// *Remove the task at the head of a queue
+// @param queue the queue to take the task from
+// @return the removed task, or nullptr if the queue is empty
+Task* task_queue_pop(TaskQueue* queue) {
+    Task* task = queue->head;
+    if (task != nullptr) task_queue_remove(queue, task);
+
+    return task;
+}
+
+// *Remove a task from any position of the queue it is in
+// @param queue the queue containing the task
+// @param task the task to be removed
+void task_queue_remove(TaskQueue* queue, Task* task) {
+    if (task->queue_prev != nullptr) task->queue_prev->queue_next = task->queue_next;
+    else queue->head = task->queue_next;
+
+    if (task->queue_next != nullptr) task->queue_next->queue_prev = task->queue_prev;
+    else queue->tail = task->queue_prev;
+
+    task->queue_next = task->queue_prev = nullptr;
+    queue->count--;
+}
+
+// *Insert a task before another one of the queue, or at its tail
+// @param queue the queue to insert the task into
+// @param before the task to insert before, or nullptr to append the task
+// @param task the task to be inserted
+void task_queue_insert_before(TaskQueue* queue, Task* before, Task* task) {
+    if (before == nullptr) {
+        task_queue_push(queue, task);
+        return;
+    }
+
+    task->queue_next = before;
+    task->queue_prev = before->queue_prev;
+
+    if (before->queue_prev != nullptr) before->queue_prev->queue_next = task;
+    else queue->head = task;
+
+    before->queue_prev = task;
+    queue->count++;
 }
@@ -4,19 +4,16 @@
 #include <stdbool.h>
 #include <neutrino/lock.h>
 #include <neutrino/macros.h>
+#include <neutrino/schedstat.h>
+#include <neutrino/cpumask.h>
+#include <neutrino/cputime.h>
+#include <neutrino/taskinfo.h>
 #include <_null.h>
 #include "context.h"
 #include "channel.h"
+#include "timer.h"
 #include "../memory/space.h"
 
-typedef enum __task_status {
-    TASK_EMBRYO,            // task is creating its Context and Space
-    TASK_NEW,               // task has never been executed before
-    TASK_READY,             // task is ready for execution
-    TASK_RUNNING,           // task is running
-    TASK_ZOMBIE             // task is ended and freeing its resources
-} TaskStatus;
-
 typedef enum __task_exit_code {
     QUIT_SUCCESS = 0xdf80,
     QUIT_GENERIC_ERROR = 0xdf81,
@@ -25,43 +22,126 @@ typedef enum __task_exit_code {
 } TaskExitCode;
 
 #define TASK_NAME_MAX 64
+#define TASK_PID_NONE   0xffffffff
+#define TASK_PRIORITY_LEVELS    8   // 0 is the highest priority level
+#define TASK_PRIORITY_DEFAULT   3
 #define PROCESS_STACK_SIZE  0x4000
+#define TASK_KSTACK_SIZE    0x8000
 #define PROCESS_STACK_BASE  0x80000000000
+#define THREAD_STACK_SLOTS  64  // threads sharing a space, below the stack of the main thread
 #define USER_HEAP_OFFSET    0xf8000000000
 
 typedef struct __task {
     uint32_t pid;
+    uint32_t parent_pid;        // task that started this one, TASK_PID_NONE for tasks started by the kernel
+    uint32_t exit_status;
     char name[TASK_NAME_MAX+1];
 
     TaskStatus status;
     struct {
-        uint16_t cpu_id;
-        bool affinity_ignored;
-    } packed cpu_affinity;
+        uint16_t cpu_id;    // last CPU the task ran on, cache-warm and chosen first when the task is queued again
+        CpuMask allowed;    // hard affinity, the task never runs on other CPUs
+        CpuMask preferred;  // soft affinity, chosen first when the task has to leave its last CPU
+    } cpu_affinity;
+    struct {
+        uint8_t base;       // priority level set for the task
+        uint8_t level;      // current priority level, raised on wakeups and lowered when slices are used up
+        uint32_t slice;     // scheduler ticks left in the current slice
+    } priority;
+    SchedClass sched_class;
+    struct {
+        uint64_t runtime;       // budget of every job, in cycles
+        uint64_t deadline;      // relative deadline of every job, in cycles
+        uint64_t period;        // time between two job releases, in cycles
+        uint64_t bandwidth;     // share of the CPU reserved by admission control, see SCHED_DL_UNIT
+
+        uint64_t budget;        // cycles left to the current job
+        uint64_t abs_deadline;  // cycle counter value the current job must be completed by
+        uint64_t release;       // cycle counter value the next job is released at
+        uint64_t last_start;    // cycle counter value the budget was last charged at
+        uint64_t misses;        // jobs completed after their deadline or not completed at all
+        uint32_t cpu_id;        // CPU the task is admitted on, it never runs elsewhere
+        bool throttled;         // the budget ran out or the job is completed, until the next release
+        bool completed;
+        Timer timer;            // releases the jobs, on the CPU of the task
+    } dl;
 
     // flags
     Lock lock;
     bool user;
     bool in_syscall;
     bool in_io;
+    volatile bool on_cpu;   // the task context is in use by a CPU, and can't be resumed anywhere else
+    bool yielded;           // the task gave up the CPU and is queued behind its level, even if its slice isn't over
 
     Context* context;       // ! must SAVE before every scheduler cycle and RESTORE thereafter
     Space* space;           // ! must SWITCH after every scheduler cycle
     Channel* channel;
 
     uintptr_t stack_base;
+    uintptr_t stack_virt;       // base of the stack in the task space
+    int8_t stack_slot;          // thread stack slot in the shared space, -1 for the stack of the main thread
+    uintptr_t kernel_stack;     // base of the kernel stack, mapped in every space
+
+    struct __task* queue_next;  // intrusive links of the queue the task is in, if any
+    struct __task* queue_prev;
+
+    struct {
+        CpuTime total;          // cycles charged to the task, idle cycles are only charged to idle tasks
+        uint64_t last_ran;      // cycle counter when the task was last charged, 0 if it never ran
+    } cputime;
+
+    struct {
+        SchedTaskStats total;
+        uint64_t queued_at;     // cycle counter when the task was queued, 0 if not tracked
+        uint64_t started_at;    // cycle counter when the task was last switched in
+        bool woken;             // the task was queued by a wakeup, rather than preempted
+    } stats;                    // collected only while the scheduler statistics are enabled
 } Task;
 
+typedef struct __task_queue {
+    Task* head;
+    Task* tail;
+    volatile size_t count;      // number of queued tasks, readable without locking as a hint
+} TaskQueue;
+
+typedef bool (*TaskVisitor)(Task* task, void* data);
+
+typedef struct __task_info_collector {
+    TaskInfo* infos;
+    size_t count;               // entries available in [infos]
+    size_t filled;
+} TaskInfoCollector;
+
+#define NewTaskQueue    (TaskQueue){nullptr, nullptr, 0}
+
 #define IsTaskRunnable(task)    ((task)->status == TASK_READY || (task)->status == TASK_NEW)
 #define IsTaskNeverRun(task)    ((task)->status == TASK_EMBRYO || (task)->status == TASK_NEW)
 
+// base of the stack of a thread, slots are separated by an unmapped guard page
+#define ThreadStackBase(slot)       (PROCESS_STACK_BASE - ((uintptr_t)(slot) + 1) * (PROCESS_STACK_SIZE + 0x1000))
+
+// top of the stack of a task, below the terminator return address
+#define TaskStackTop(task)          ((task)->stack_virt + PROCESS_STACK_SIZE - sizeof(uintptr_t))
+
+// top of the kernel stack of a task, below the terminator return address
+#define TaskKernelStackTop(task)    ((task)->kernel_stack + TASK_KSTACK_SIZE - sizeof(uintptr_t))
+
 Task* NewTask(char* name, bool user);
+Task* NewThread(Task* process);
 Task* NewIdleTask(uintptr_t entry_point);
 void DestroyTask(Task* task);
 Task* get_current_task();
+bool task_info(uint32_t pid, TaskInfo* info);
+size_t task_list(uint32_t from, TaskInfo* infos, size_t count);
 void task_start_syscall();
 void task_end_syscall();
 
+void task_queue_push(TaskQueue* queue, Task* task);
+Task* task_queue_pop(TaskQueue* queue);
+void task_queue_remove(TaskQueue* queue, Task* task);
+void task_queue_insert_before(TaskQueue* queue, Task* before, Task* task);
+
 #ifdef __x86_64
 #include "kernel/x86_64/tasks/task.h"
 #else
@@ -69,3 +149,5 @@ void task_end_syscall();
 #endif
 
 void task_set_stack(Task* task, bool user);
+bool task_set_thread_stack(Task* task, bool user);
+void task_free_thread_stack(Task* task);
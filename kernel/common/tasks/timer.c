@@ -0,0 +1,131 @@
+#include "timer.h"
+#include "arch.h"
+#include "kernel/common/cpu.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <_null.h>
+#include <neutrino/lock.h>
+#include <neutrino/macros.h>
+
+#ifdef __x86_64
+#include "kernel/x86_64/interrupts.h"
+#else
+#error "Unsupported platform"
+#endif
+
+static TimerQueue timer_queues[MAX_CPU];
+
+// === PUBLIC FUNCTIONS =========================
+
+// *Arm a timer on the current CPU, calling its callback from the timer interrupt once [ns] nanoseconds passed.
+// *The timer must stay valid until it expires or is cancelled
+// @param timer the timer to arm, not armed already
+// @param ns the delay before the timer expires, in nanoseconds
+void timer_arm(Timer* timer, uint64_t ns) {
+    bool enabled = interrupts_save();
+    timer_arm_at(timer, get_current_cpu()->id, read_tsc() + arch_ns_to_cycles(ns));
+    interrupts_restore(enabled);
+}
+
+// *Arm a timer on the given CPU, calling its callback from the timer interrupt of that CPU at [deadline]
+// @param timer the timer to arm, not armed already
+// @param cpu_id the CPU the callback runs on
+// @param deadline the cycle counter value the timer expires at
+void timer_arm_at(Timer* timer, uint32_t cpu_id, uint64_t deadline) {
+    bool enabled = interrupts_save();
+    volatile Cpu* cpu = get_current_cpu();
+    TimerQueue* queue = &timer_queues[cpu_id];
+
+    timer->deadline = deadline;
+    timer->cpu_id = cpu_id;
+
+    lock(&queue->lock);
+    Timer** link = &queue->head;
+    while (*link != nullptr && (*link)->deadline <= timer->deadline) link = &(*link)->next;
+
+    timer->next = *link;
+    *link = timer;
+    unlock(&queue->lock);
+
+    // a tickless CPU only wakes up on its one-shot interrupt, which may be later than the new deadline.
+    // A remote CPU is kicked, and programs its timer again on its next cycle
+    if (queue->head == timer && get_cpu(cpu_id)->tasks.tickless) {
+        uint64_t now = read_tsc();
+        if (cpu_id != cpu->id) cpu_kick(cpu_id);
+        else arch_timer_oneshot((deadline > now) ? arch_cycles_to_ms(deadline - now) : 1);
+    }
+
+    interrupts_restore(enabled);
+}
+
+// *Disarm a timer before it expires
+// @param timer the timer to cancel
+// @return true if the timer was disarmed, false if it already expired and its callback may be running
+bool timer_cancel(Timer* timer) {
+    bool enabled = interrupts_save();
+    int32_t cpu_id = timer->cpu_id;
+    bool found = false;
+
+    if (cpu_id >= 0) {
+        TimerQueue* queue = &timer_queues[cpu_id];
+        lock(&queue->lock);
+
+        Timer** link = &queue->head;
+        while (*link != nullptr && *link != timer) link = &(*link)->next;
+        if (*link != nullptr) {
+            *link = timer->next;
+            timer->cpu_id = -1;
+            found = true;
+        }
+
+        unlock(&queue->lock);
+    }
+
+    interrupts_restore(enabled);
+    return found;
+}
+
+// *Run the callbacks of the expired timers of a CPU. Expired timers are detached in a single batch,
+// *then called without holding the queue lock. Must be called from the timer interrupt
+// @param cpu_id the CPU to expire the timers of
+void timer_expire(uint32_t cpu_id) {
+    TimerQueue* queue = &timer_queues[cpu_id];
+    if (queue->head == nullptr) return;
+
+    uint64_t now = read_tsc();
+    Timer* expired = nullptr;
+    lock(&queue->lock);
+
+    Timer** link = &queue->head;
+    while (*link != nullptr && (*link)->deadline <= now) {
+        (*link)->cpu_id = -1;
+        link = &(*link)->next;
+    }
+
+    if (link != &queue->head) {
+        Timer* pending = *link;
+        *link = nullptr;
+        expired = queue->head;
+        queue->head = pending;
+    }
+
+    unlock(&queue->lock);
+
+    // the callback may release the timer, the next one must be read first
+    while (expired != nullptr) {
+        Timer* next = expired->next;
+        expired->callback(expired);
+        expired = next;
+    }
+}
+
+// *Get the deadline of the first timer of a CPU
+// @param cpu_id the id of the CPU
+// @return the cycle counter value the first timer expires at, 0 if no timer is armed
+uint64_t timer_next_deadline(uint32_t cpu_id) {
+    TimerQueue* queue = &timer_queues[cpu_id];
+    if (queue->head == nullptr) return 0;
+
+    LockRetain(queue->lock);
+    return (queue->head != nullptr) ? queue->head->deadline : 0;
+}
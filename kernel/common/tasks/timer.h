@@ -0,0 +1,26 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <_null.h>
+#include <neutrino/lock.h>
+
+typedef struct __timer {
+    uint64_t deadline;                      // cycle counter value the timer expires at
+    void (*callback)(struct __timer* timer);
+    void* data;
+    int32_t cpu_id;                         // CPU the timer is armed on, -1 if it's not armed
+    struct __timer* next;
+} Timer;
+
+typedef struct __timer_queue {
+    Lock lock;
+    Timer* head;                            // armed timers, sorted by deadline
+} TimerQueue;
+
+#define NewTimer(callback, data)    (Timer){0, callback, data, -1, nullptr}
+
+void timer_arm(Timer* timer, uint64_t ns);
+void timer_arm_at(Timer* timer, uint32_t cpu_id, uint64_t deadline);
+bool timer_cancel(Timer* timer);
+void timer_expire(uint32_t cpu_id);
+uint64_t timer_next_deadline(uint32_t cpu_id);
@@ -0,0 +1,76 @@
+#include "waitqueue.h"
+#include "scheduler.h"
+#include "task.h"
+#include "kernel/common/cpu.h"
+#include <stdbool.h>
+#include <size_t.h>
+#include <_null.h>
+#include <neutrino/lock.h>
+
+#ifdef __x86_64
+#include "kernel/x86_64/interrupts.h"
+#else
+#error "Unsupported platform"
+#endif
+
+// === PUBLIC FUNCTIONS =========================
+
+// *Block the current task on the wait queue until it is woken up. If [held] is given, it is released
+// *only after the task is queued, so that a wakeup done under the same lock can't be lost.
+// *The lock is NOT taken again on return
+// @param queue the wait queue to block on
+// @param held the lock protecting the awaited condition, or nullptr
+void wait_queue_sleep(WaitQueue* queue, Lock* held) {
+    bool enabled = interrupts_save();
+    Task* task = get_current_task();
+
+    lock(&queue->lock);
+    task->status = TASK_BLOCKED;
+    task_queue_push(&queue->tasks, task);
+    unlock(&queue->lock);
+
+    if (held != nullptr) unlock(held);
+
+    sched_yield();
+    interrupts_restore(enabled);
+}
+
+// *Wake up the task waiting for the longest time on the wait queue
+// @param queue the wait queue to wake the task from
+// @return true if a task was woken up, false if the queue was empty
+bool wait_queue_wake_one(WaitQueue* queue) {
+    if (queue->tasks.count == 0) return false;
+
+    bool enabled = interrupts_save();
+    lock(&queue->lock);
+    Task* task = task_queue_pop(&queue->tasks);
+    unlock(&queue->lock);
+
+    if (task != nullptr) sched_wake(task);
+    interrupts_restore(enabled);
+
+    return task != nullptr;
+}
+
+// *Wake up every task waiting on the wait queue
+// @param queue the wait queue to empty
+// @return the number of woken up tasks
+size_t wait_queue_wake_all(WaitQueue* queue) {
+    if (queue->tasks.count == 0) return 0;
+
+    bool enabled = interrupts_save();
+    lock(&queue->lock);
+    TaskQueue woken = queue->tasks;
+    queue->tasks = NewTaskQueue;
+    unlock(&queue->lock);
+
+    size_t count = 0;
+    Task* task;
+    while ((task = task_queue_pop(&woken)) != nullptr) {
+        sched_wake(task);
+        count++;
+    }
+
+    interrupts_restore(enabled);
+    return count;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include "task.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <size_t.h>
+#include <neutrino/lock.h>
+
+typedef struct __wait_queue {
+    Lock lock;
+    TaskQueue tasks;        // blocked tasks, in the order they started waiting
+} WaitQueue;
+
+#define NewWaitQueue    (WaitQueue){NewLock, NewTaskQueue}
+
+void wait_queue_sleep(WaitQueue* queue, Lock* held);
+bool wait_queue_wake_one(WaitQueue* queue);
+size_t wait_queue_wake_all(WaitQueue* queue);
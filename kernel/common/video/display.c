@@ -51,7 +51,7 @@ Color color_blend(Color back, Color top) {
     };
 }
 
-void unoptimized put_pixel(uint32_t pos_x, uint32_t pos_y, Color color) {
+void put_pixel(uint32_t pos_x, uint32_t pos_y, Color color) {
     uintptr_t pixel = (uintptr_t)(info.lbf + pos_y*info.pitch + pos_x*(info.bpp/8));
 
     uint32_t dest = *(volatile uint32_t*)(pixel);
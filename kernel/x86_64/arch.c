@@ -23,6 +23,18 @@
 #include <neutrino/macros.h>
 #include <neutrino/time.h>
 
+// the idle loop waits with MONITOR/MWAIT rather than hlt
+static bool idle_mwait = false;
+
+// *Choose how the idle tasks wait, from the features reported by CPUID. Kernels built with IDLE_MWAIT=0 always
+// *halt, so that the boot benchmark can compare both idle loops
+void init_idle() {
+#ifndef __idle_hlt
+    idle_mwait = get_cpuid_availability() && get_cpu_feature(CPUID_FEAT_ECX_MONITOR, true);
+#endif
+    ks.log("Idle loop uses %c", idle_mwait ? "MONITOR/MWAIT" : "HLT");
+}
+
 void kinit_mem_manager(struct stivale2_struct_tag_memmap* memmap_str_tag, MemoryPhysicalRegion* entries) {
     uint32_t memmap_entries = memmap_str_tag->entries;
     int i = 0, lookahead = 1;
@@ -59,7 +71,7 @@ void kinit_mem_manager(struct stivale2_struct_tag_memmap* memmap_str_tag, Memory
     init_vmm();
 }
 
-void unoptimized _kstart(struct stivale2_struct *stivale2_struct) {
+void _kstart(struct stivale2_struct *stivale2_struct) {
     struct stivale2_struct_tag_memmap *memmap_str_tag = stivale2_get_tag(stivale2_struct, STIVALE2_STRUCT_TAG_MEMMAP_ID);
     struct stivale2_struct_tag_smp *smp_str_tag = stivale2_get_tag(stivale2_struct, STIVALE2_STRUCT_TAG_SMP_ID);
     struct stivale2_struct_tag_modules *modules = stivale2_get_tag(stivale2_struct, STIVALE2_STRUCT_TAG_MODULES_ID);
@@ -74,6 +86,7 @@ void unoptimized _kstart(struct stivale2_struct *stivale2_struct) {
     init_gdt();
     init_idt();
     init_cpuid();
+    init_idle();
 
     kinit_mem_manager(memmap_str_tag, entries);
 
@@ -101,10 +114,68 @@ void unoptimized _kstart(struct stivale2_struct *stivale2_struct) {
     for (;;) asm volatile("hlt");
 }
 
+// *Idle loop of the idle tasks. When MONITOR/MWAIT is available, the CPU waits for a write to its need_resched
+// *word, so that other CPUs can wake it up without an interrupt. It halts until the next interrupt otherwise
 void arch_idle() {
-    while (true) asm volatile ("hlt");
+    volatile Cpu* cpu = get_current_cpu();
+
+    while (true) {
+        if (idle_mwait) {
+            // a write after MONITOR makes MWAIT return at once, need_resched can't be missed after the check
+            __atomic_store_n(&cpu->tasks.polling, true, __ATOMIC_SEQ_CST);
+            asm volatile ("monitor" : : "a"(&cpu->tasks.need_resched), "c"(0), "d"(0) : "memory");
+            if (!cpu->tasks.need_resched) asm volatile ("mwait" : : "a"(0), "c"(0) : "memory");
+            cpu->tasks.polling = false;
+        } else {
+            asm volatile ("hlt");
+        }
+
+        if (cpu->tasks.need_resched) arch_yield();
+    }
+}
+
+// *Switch to the next task through the scheduler yield interrupt
+void arch_yield() {
+    asm volatile ("int %0" : : "i"(SCHED_YIELD_IRQ) : "memory");
 }
 
 Timestamp arch_now() {
     return datetime_to_timestamp(cmos_read());
 }
+
+// *Make the timer of the current CPU fire on every scheduler tick
+void arch_timer_periodic() {
+    apic_timer_periodic();
+}
+
+// *Make the timer of the current CPU fire once, after [ms] milliseconds
+// @param ms the delay before the timer interrupt, in milliseconds
+void arch_timer_oneshot(uint64_t ms) {
+    apic_timer_oneshot(ms);
+}
+
+// *Convert a duration to cycles of the time-stamp counter of the current CPU
+// @param ns the duration, in nanoseconds
+// @return the number of cycles
+uint64_t arch_ns_to_cycles(uint64_t ns) {
+    uint64_t tsc_per_ms = get_current_cpu()->timer.tsc_per_ms;
+    return (ns / 1000000) * tsc_per_ms + (ns % 1000000) * tsc_per_ms / 1000000;
+}
+
+// *Convert cycles of the time-stamp counter of the current CPU to milliseconds, rounding up
+// @param cycles the number of cycles
+// @return the duration, in milliseconds
+uint64_t arch_cycles_to_ms(uint64_t cycles) {
+    uint64_t tsc_per_ms = get_current_cpu()->timer.tsc_per_ms;
+    if (tsc_per_ms == 0) return 1;
+    return (cycles + tsc_per_ms - 1) / tsc_per_ms;
+}
+
+// *Convert cycles of the time-stamp counter of the current CPU to nanoseconds
+// @param cycles the number of cycles
+// @return the duration, in nanoseconds
+uint64_t arch_cycles_to_ns(uint64_t cycles) {
+    uint64_t tsc_per_ms = get_current_cpu()->timer.tsc_per_ms;
+    if (tsc_per_ms == 0) return 0;
+    return (cycles / tsc_per_ms) * 1000000 + (cycles % tsc_per_ms) * 1000000 / tsc_per_ms;
+}
@@ -6,6 +6,7 @@
 #define MEMV_OFFSET 0xffff800000000000
 #define PERM_OFFSET 0xffff880000000000
 #define MMIO_OFFSET 0xfffff00000000000
+#define VMAL_OFFSET 0xfffffc0000000000
 #define HEAP_OFFSET 0xfffffe0000000000
 #define KERN_OFFSET 0xffffffff80000000
 
@@ -20,6 +21,7 @@ MemoryFunctions(kern, KERN_OFFSET)
 
 enum MSR_REGISTERS {
     APIC =              0x1B,
+    TSC_DEADLINE =      0x6E0,
     EFER =              0xC0000080,
     STAR =              0xC0000081,
     LSTAR =             0xC0000082,
@@ -45,8 +47,23 @@ static inline uint64_t read_msr(uint64_t msr) {
 // @param msr the model specific register to write
 // @param value the value to write to the register
 static inline void write_msr(uint64_t msr, uint64_t value) {
-    asm volatile("wrmsr" : : "c"(msr), "a"(value & 0xFFFFFFFF), "d"(value >> 32));
+    asm volatile("wrmsr" : : "c"(msr), "a"(value & 0xFFFFFFFF), "d"(value >> 32) : "memory");
 }
 
+// *Read the time-stamp counter of the current CPU
+// @return the current value of the time-stamp counter
+static inline uint64_t read_tsc() {
+    uint32_t low, high;
+    asm volatile("rdtsc" : "=a"(low), "=d"(high));
+    return ((uint64_t)high << 32) | low;
+}
+
+void init_idle();
 void arch_idle();
+void arch_yield();
 Timestamp arch_now();
+void arch_timer_periodic();
+void arch_timer_oneshot(uint64_t ms);
+uint64_t arch_ns_to_cycles(uint64_t ns);
+uint64_t arch_cycles_to_ms(uint64_t cycles);
+uint64_t arch_cycles_to_ns(uint64_t cycles);
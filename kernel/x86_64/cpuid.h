@@ -48,6 +48,7 @@ typedef enum {
     CPUID_FEAT_ECX_x2APIC       = 1 << 21, 
     CPUID_FEAT_ECX_MOVBE        = 1 << 22, 
     CPUID_FEAT_ECX_POPCNT       = 1 << 23, 
+    CPUID_FEAT_ECX_TSC_DEADLINE = 1 << 24, 
     CPUID_FEAT_ECX_AES          = 1 << 25, 
     CPUID_FEAT_ECX_XSAVE        = 1 << 26, 
     CPUID_FEAT_ECX_OSXSAVE      = 1 << 27, 
@@ -10,11 +10,13 @@
 #include "arch.h"
 #include <neutrino/macros.h>
 
+struct acpi acpi;
+
 // === PRIVATE FUNCTIONS ========================
 
 // *Find the RSDP descriptor and return a pointer to it
 // @return a pointer to the RSDP descriptor
-void* unoptimized find_rsdp() {
+void* find_rsdp() {
     for (uintptr_t i = get_mem_address(RSDP_LOW); i < get_mem_address(RSDP_HIGH); i+=0x10) {
         char* candidate = (char*)i;
         if (strncmp(candidate, "RSD PTR ", 8) == 0) return (void*)candidate;
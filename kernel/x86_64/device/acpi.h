@@ -92,7 +92,7 @@ struct acpi {
     };
 };
 
-struct acpi acpi;
+extern struct acpi acpi;
 
 void init_acpi();
 void *find_sdt_entry(const char* entry_sign);
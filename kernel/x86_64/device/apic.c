@@ -2,6 +2,7 @@
 #include "arch.h"
 #include "smp.h"
 #include "pic.h"
+#include "cpuid.h"
 #include "interrupts.h"
 #include "memory/mem_virt.h"
 #include "device/acpi.h"
@@ -11,6 +12,8 @@
 #include "time/pit.h"
 #include <neutrino/macros.h>
 
+struct apic_t apic;
+
 // === PRIVATE FUNCTIONS ========================
 
 // *Write a value to the specified IOAPIC register
@@ -106,7 +109,7 @@ void apic_set_raw_redirect(uint8_t vector, uint32_t target_gsi, uint16_t flags,
 // === PUBLIC FUNCTIONS =========================
 
 // *Intialize the APIC
-void unoptimized init_apic() {
+void init_apic() {
     ks.log("Initializing APIC...");
 
     disable_interrupts();
@@ -116,6 +119,7 @@ void unoptimized init_apic() {
     apic.apic_addr = madt->lapic_address;
 
     apic.x2apic_enabled = false;
+    apic.tsc_deadline = get_cpu_feature(CPUID_FEAT_ECX_TSC_DEADLINE, true);
 
     map_apic();      // map the LAPIC address into space
     enable_apic();              // enable the APIC
@@ -129,12 +133,12 @@ void unoptimized init_apic() {
 }
 
 // *Map the LAPIC into the active table
-void unoptimized map_apic() {
+void map_apic() {
     apic.apic_addr = vmm_map_mmio((uintptr_t)apic.apic_addr, 3);
 }
 
 // *Map the LAPIC into the active table for an AP
-void unoptimized map_apic_on_ap() {
+void map_apic_on_ap() {
     vmm_map_mmio(get_rmmio_address((uintptr_t)apic.apic_addr), 3);
 }
 
@@ -182,15 +186,37 @@ uint32_t apic_read(enum apic_register reg) {
     return *((volatile uint32_t *)((uintptr_t)apic.apic_addr + reg));
 }
 
+// *Send an inter-processor interrupt to a single CPU
+// @param lapic_id the LAPIC id of the target CPU
+// @param vector the interrupt vector to raise on the target CPU
+void apic_send_ipi(uint32_t lapic_id, uint8_t vector) {
+    while (apic_read(icr1) & IPI_DELIVERY_PENDING) asm volatile ("pause");
+
+    apic_write(icr2, lapic_id << 24);
+    apic_write(icr1, vector);
+}
+
+// *Send an inter-processor interrupt to every CPU but the current one
+// @param vector the interrupt vector to raise on the target CPUs
+void apic_broadcast_ipi(uint8_t vector) {
+    while (apic_read(icr1) & IPI_DELIVERY_PENDING) asm volatile ("pause");
+
+    apic_write(icr2, 0);
+    apic_write(icr1, vector | IPI_ALL_EXCLUDING_SELF);
+}
+
 // *Send a EOI to the APIC
 void apic_eoi() {
     apic_write(eoi, 0);
 }
 
-// *Initialize the LAPIC timer
+// *Initialize the LAPIC timer of the current CPU in periodic mode, calibrating it and the TSC against the HPET or the PIT
 void init_apic_timer() {
+    Cpu* cpu = get_current_cpu();
+
     apic_write(timer_div, apic_timer_divide_by_16);
     apic_write(timer_init_counter, 0xffffffff);
+    uint64_t tsc_start = read_tsc();
 
     if (has_hpet()) hpet_sleep(10);
     else pit_sleep(10);
@@ -198,7 +224,47 @@ void init_apic_timer() {
     apic_write(lvt_timer, LAPIC_TIMER_MASKED);
     uint64_t elapsed = 0xffffffff - apic_read(timer_current);
 
+    cpu->timer.period = elapsed / 10;
+    cpu->timer.tsc_per_ms = (read_tsc() - tsc_start) / 10;
+    cpu->timer.mode = apic_mode_one_shot;       // force the reprogramming
+    apic_timer_periodic();
+}
+
+// *Set the LAPIC timer of the current CPU in periodic mode, firing every scheduler tick
+void apic_timer_periodic() {
+    Cpu* cpu = get_current_cpu();
+    if (cpu->timer.mode == apic_mode_periodic) return;
+
     apic_write(lvt_timer, APIC_TIMER_IRQ | (apic_mode_periodic << 17));
     apic_write(timer_div, apic_timer_divide_by_16);
-    apic_write(timer_init_counter, elapsed / 10);
+    apic_write(timer_init_counter, cpu->timer.period);
+    cpu->timer.mode = apic_mode_periodic;
+}
+
+// *Set the LAPIC timer of the current CPU to fire only once, after [ms] milliseconds.
+// *The TSC-deadline mode is used when available, the one-shot mode otherwise
+// @param ms the delay before the timer interrupt, in milliseconds
+void apic_timer_oneshot(uint64_t ms) {
+    Cpu* cpu = get_current_cpu();
+    if (ms == 0) ms = 1;
+
+    if (apic.tsc_deadline && cpu->timer.tsc_per_ms > 0) {
+        if (cpu->timer.mode != apic_mode_tsc_deadline) {
+            apic_write(lvt_timer, APIC_TIMER_IRQ | (apic_mode_tsc_deadline << 17));
+            asm volatile("mfence" ::: "memory");    // the LVT write must be visible before arming the deadline
+            cpu->timer.mode = apic_mode_tsc_deadline;
+        }
+
+        write_msr(TSC_DEADLINE, read_tsc() + ms * cpu->timer.tsc_per_ms);
+        return;
+    }
+
+    uint64_t count = ms * cpu->timer.period;
+    if (cpu->timer.mode != apic_mode_one_shot) {
+        apic_write(lvt_timer, APIC_TIMER_IRQ | (apic_mode_one_shot << 17));
+        apic_write(timer_div, apic_timer_divide_by_16);
+        cpu->timer.mode = apic_mode_one_shot;
+    }
+
+    apic_write(timer_init_counter, (count > 0xffffffff ? 0xffffffff : (uint32_t)count));
 }
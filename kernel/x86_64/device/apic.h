@@ -6,7 +6,10 @@
 #define LAPIC_ENABLE (1 << 10)
 #define LAPIC_TIMER_MASKED (1 << 16)
 
-#define LapicIDCorrection(val) (apic.x2apic_enabled) ? (val) : (val > 24)
+#define LapicIDCorrection(val) ((apic.x2apic_enabled) ? (val) : ((val) >> 24))
+
+#define IPI_DELIVERY_PENDING    (1 << 12)
+#define IPI_ALL_EXCLUDING_SELF  (0b11 << 18)
 
 enum apic_register {
     lapic_id =  0x20,
@@ -69,6 +72,7 @@ struct io_apic_version_table {
 struct apic_t {
     uint64_t apic_addr;
     bool x2apic_enabled;
+    bool tsc_deadline;      // the LAPIC timer supports the TSC-deadline mode
 
     uint16_t ioapics_count;
     MadtApicIOApic* ioapics[64];
@@ -77,7 +81,7 @@ struct apic_t {
     MadtApicIOApicISO* ioapics_iso[64];
 };
 
-struct apic_t apic;
+extern struct apic_t apic;
 
 void init_apic();
 void enable_apic();
@@ -88,5 +92,9 @@ void map_apic();
 void map_apic_on_ap();
 void apic_redirect_irq(uint32_t cpu, uint8_t irq, uint32_t status);
 void apic_set_legacy_irq_redirect();
+void apic_send_ipi(uint32_t lapic_id, uint8_t vector);
+void apic_broadcast_ipi(uint8_t vector);
 
 void init_apic_timer();
+void apic_timer_periodic();
+void apic_timer_oneshot(uint64_t ms);
@@ -7,6 +7,8 @@
 #include "neutrino/macros.h"
 #include "stdbool.h"
 
+struct hpet hpet;
+
 // === PRIVATE FUNCTIONS ========================
 
 // *Write the value to the given HPET register
@@ -32,7 +34,7 @@ bool has_hpet() {
 }
 
 // *Initialize the HPET
-void unoptimized init_hpet() {
+void init_hpet() {
     ks.log("Initializing HPET...");
     hpet.table_pointer = (struct HPET*)find_sdt_entry("HPET");
 
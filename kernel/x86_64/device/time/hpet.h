@@ -44,7 +44,7 @@ struct hpet {
     uint64_t clock_period;
 };
 
-struct hpet hpet;
+extern struct hpet hpet;
 
 bool has_hpet();
 void init_hpet();
@@ -4,6 +4,8 @@
 #include "interrupts.h"
 #include "stdint.h"
 
+struct pit pit;
+
 // === PRIVATE FUNCTIONS ========================
 
 // *Read the current value from the PIT
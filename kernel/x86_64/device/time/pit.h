@@ -44,7 +44,7 @@ struct pit {
     uint64_t ticks;
 };
 
-struct pit pit;
+extern struct pit pit;
 
 void init_pit(uint64_t target_frequency);
 void pit_sleep(uint16_t timeout);
@@ -1,5 +1,6 @@
 #include "gdt.h"
 #include "smp.h"
+#include "arch.h"
 #include "kservice.h"
 #include "memory/mem_phys.h"
 #include "memory/mem_virt.h"
@@ -67,20 +68,23 @@ void init_gdt_on_ap(uint32_t cpu_id) {
 
 // *Setup the TSS
 // @param cpu the structure information of the cpu
-void unoptimized init_tss(Cpu* cpu) {
+void init_tss(Cpu* cpu) {
     ks.dbg("Setting up TSS...");
     // tss descriptor 0x28
     struct TSS_entry entry = tss_entry_create((uint64_t)&(cpu->tss), (uint64_t)&(cpu->tss) + sizeof(cpu->tss), GDT_TSS_PRESENT | GDT_TSS, GDT_FLAGS_TSS);
     gdt_array[cpu->id].TSS = entry;
 
-    // setup tss.ist1
+    // setup tss.rsp0, reachable from every page table through the physical memory mirror
     cpu->tss.iopb_offset = sizeof(Tss);
-    cpu->tss.rsp0 = (uint64_t)cpu->stack;
+    cpu->stack_kernel = (uint8_t*)pmm_alloc_series(CPU_STACK_SIZE / PAGE_SIZE);
+    cpu->tss.rsp0 = get_perm_address((uintptr_t)cpu->stack_kernel) + CPU_STACK_SIZE;
+
+    // setup tss.ist1. Each CPU has its own slot, since the stack pml4 entry is shared by every page table
     cpu->stack_interrupt = (uint8_t*)pmm_alloc_series(CPU_STACK_SIZE / PAGE_SIZE);
-    cpu->tss.ist1 = CPU_STACK_BASE + CPU_STACK_SIZE;
+    cpu->tss.ist1 = CpuStackBase(cpu->id) + CPU_STACK_SIZE;
 
     for (uint32_t i = 0; i < CPU_STACK_SIZE / PAGE_SIZE; i++)
-        vmm_map_page(cpu->page_table, (uintptr_t)cpu->stack_interrupt + i*PAGE_SIZE, CPU_STACK_BASE + i*PAGE_SIZE, PageKernelWrite);
+        vmm_map_page(cpu->page_table, (uintptr_t)cpu->stack_interrupt + i*PAGE_SIZE, CpuStackBase(cpu->id) + i*PAGE_SIZE, PageKernelWrite);
 
     install_tss();
     ks.dbg("TSS set up for CPU #%u", cpu->id);
@@ -2,11 +2,15 @@
 #include "kservice.h"
 #include "pic.h"
 #include "device/apic.h"
+#include "memory/mem_virt.h"
 #include "device/time/pit.h"
 #include "kernel/common/device/port.h"
 #include "kernel/common/tasks/context.h"
+#include "tasks/context.h"
 #include "kernel/common/memory/space.h"
 #include "kernel/common/tasks/scheduler.h"
+#include "kernel/common/tasks/schedstat.h"
+#include "kernel/common/tasks/timer.h"
 #include "kernel/common/cpu.h"
 #include <stdint.h>
 #include <neutrino/macros.h>
@@ -57,7 +61,7 @@ const char *interrupt_exception_name[] = {
 // @param isr the pointer to the Interrupt Service Routine
 // @param ist the offset of the interrupt stack table stored in the TSS
 // @param type_attr the attributes for the newly added idt entry
-void unoptimized set_idt_entry(uint32_t irq, int(*isr)(), uint16_t ist, uint8_t type_attr) {
+void set_idt_entry(uint32_t irq, int(*isr)(), uint16_t ist, uint8_t type_attr) {
 	uint64_t irq_address = (uint64_t)isr;
 	IDT[irq].offset_lowerbits = (irq_address) & 0xffff;
 	IDT[irq].selector = KERNEL_CODE;
@@ -71,7 +75,7 @@ void unoptimized set_idt_entry(uint32_t irq, int(*isr)(), uint16_t ist, uint8_t
 
 // *Log the interrupt stack passed to the function. Useful for debugging interrupts stack frames
 // @param stack the pointer to the interrupt stack to be logged
-void unoptimized log_interrupt(InterruptStack* stack) {
+void log_interrupt(InterruptStack* stack) {
     ks.dbg(" ========== INTERRUPT FRAME LOG ==========\n\
             Got interrupt %u with error_code %x on cpu #%d \n\
             Previous stack frame was %x \n\
@@ -98,8 +102,8 @@ void unoptimized log_interrupt(InterruptStack* stack) {
 
 // *Initialize the Interrupt Descriptor Table
 void init_idt() {
-	for (uint64_t i = 0; i < 48; i++) {
-		if (i == 0x0e || i == 0x08 || i == 0x0d || i == 0x20) 
+	for (uint64_t i = 0; i < IRQ_COUNT; i++) {
+		if (i == 0x0e || i == 0x08 || i == 0x0d) 
 			set_idt_entry(i, _interrupt_vector[i], 1, INTERRUPT_GATE);
 		else
 			set_idt_entry(i, _interrupt_vector[i], 0, INTERRUPT_GATE);
@@ -136,6 +140,9 @@ InterruptStack* exception_handler(InterruptStack* stack) {
         case 14:    // PF
             pagefault_handler(stack);
             break;
+        case 7:     // NM
+            context_simd_trap();
+            return stack;
 
         default: 
            log_interrupt(stack);
@@ -146,26 +153,63 @@ InterruptStack* exception_handler(InterruptStack* stack) {
     return stack;
 }
 
-InterruptStack* unoptimized interrupt_handler(InterruptStack* stack) {
+InterruptStack* interrupt_handler(InterruptStack* stack) {
+
+    if (stack->irq == SCHED_YIELD_IRQ) {    // a task is giving up the CPU and can't be skipped, no EOI needed
+        volatile Cpu* cpu = get_current_cpu();
+        lock((Lock*)&(cpu->tasks.is_switching));
+
+        context_save(cpu->tasks.current->context, stack);
+        sched_cycle(cpu);
+        stack = context_load(cpu->tasks.current->context);
+        space_switch(cpu->tasks.current->space);
+
+        unlock((Lock*)&(cpu->tasks.is_switching));
+        return stack;
+    }
+
+    if (stack->irq == TLB_SHOOTDOWN_IRQ) vmm_tlb_service();
+
+    if (stack->irq == SCHED_KICK_IRQ && scheduler.ready) {     // a task was queued here, no timer expires
+        volatile Cpu* cpu = get_current_cpu();
+
+        if (sched_kick(cpu) && try_lock((Lock*)&cpu->tasks.is_switching)) {
+            lock((Lock*)&(cpu->tasks.is_switching));
+
+            context_save(cpu->tasks.current->context, stack);
+            sched_cycle(cpu);
+            stack = context_load(cpu->tasks.current->context);
+            space_switch(cpu->tasks.current->space);
+
+            unlock((Lock*)&(cpu->tasks.is_switching));
+        }
+    }
 
     if (stack->irq == APIC_TIMER_IRQ) {     // timer interrupt, do task switch
         if (scheduler.ready) {
             volatile Cpu* cpu = get_current_cpu();
-            if (try_lock((Lock*)&cpu->tasks.is_switching)) {
+            timer_expire(cpu->id);     // sleeping tasks are queued before choosing the next task
+
+            if (!preempt_enabled(cpu)) {
+                // the task holds a lock other CPUs may spin on, it's switched out by preempt_enable()
+                cpu->tasks.need_resched = true;
+                if (cpu->tasks.tickless) apic_timer_oneshot(1);
+            } else if (try_lock((Lock*)&cpu->tasks.is_switching)) {
                 lock((Lock*)&(cpu->tasks.is_switching));
+                uint64_t start = schedstat_begin();
+
+                if (cpu->tasks.current != nullptr && !IsTaskNeverRun(cpu->tasks.current))
+                    context_save(cpu->tasks.current->context, stack);     // save context to task
                 
-                if (liballoc_try_lock()) {
-                    if (cpu->tasks.current != nullptr && !IsTaskNeverRun(cpu->tasks.current))
-                        context_save(cpu->tasks.current->context, stack);     // save context to task
-                    
-                    sched_cycle(cpu);
-                    context_load(cpu->tasks.current->context, stack);     // load context from task
-
-                    space_switch(cpu->tasks.current->space);              // switch space
-                    
-                    unlock((Lock*)&(cpu->tasks.is_switching));
-                }
-                
+                sched_cycle(cpu);
+                stack = context_load(cpu->tasks.current->context);    // switch to the task kernel stack
+
+                space_switch(cpu->tasks.current->space);              // switch space
+                schedstat_record_timer(cpu, start);
+
+                unlock((Lock*)&(cpu->tasks.is_switching));
+            } else if (cpu->tasks.tickless) {
+                apic_timer_oneshot(1);      // the switch was skipped, a one-shot timer must be armed again
             }
         }
     }
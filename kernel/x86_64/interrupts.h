@@ -1,5 +1,6 @@
 #pragma once
 #include <stdint.h>
+#include <stdbool.h>
 #include <neutrino/macros.h>
 
 #define INTERRUPT_GATE  0x8e
@@ -9,6 +10,10 @@
 #define IDT_SIZE        256
 
 #define APIC_TIMER_IRQ  32
+#define SCHED_YIELD_IRQ 48      // software interrupt raised by a task giving up the CPU
+#define TLB_SHOOTDOWN_IRQ   49  // IPI asking a CPU to flush its TLB
+#define SCHED_KICK_IRQ  50      // IPI telling a CPU that a task was queued on it, see cpu_kick()
+#define IRQ_COUNT       51
 
 struct IDT_entry {
     uint16_t offset_lowerbits;
@@ -63,11 +68,25 @@ InterruptStack* interrupt_handler(InterruptStack* stack);
 void pagefault_handler(InterruptStack* stack);
 
 static inline void disable_interrupts() {
-    asm volatile ("cli");
+    asm volatile ("cli" ::: "memory");
 }
 
 static inline void enable_interrupts() {
-    asm volatile ("sti");
+    asm volatile ("sti" ::: "memory");
+}
+
+// *Disable interrupts on the current CPU, returning their previous state
+// @return true if interrupts were enabled, false otherwise
+static inline bool interrupts_save() {
+    uint64_t rflags;
+    asm volatile ("pushfq; pop %0; cli" : "=r"(rflags) : : "memory");
+    return (rflags & (1 << 9)) != 0;
+}
+
+// *Restore the interrupts state returned by interrupts_save()
+// @param enabled true if interrupts were enabled
+static inline void interrupts_restore(bool enabled) {
+    if (enabled) enable_interrupts();
 }
 
 extern int load_idt(uintptr_t);
@@ -6,6 +6,7 @@ global load_idt
  
 extern interrupt_handler
 extern exception_handler
+extern sched_finish_switch
 
 %macro pushall 0
     push rax
@@ -87,6 +88,7 @@ _generic_interrupt:
   mov rdi, rsp
   call interrupt_handler
   mov rsp, rax
+  call sched_finish_switch  ; the previous task can be resumed elsewhere only once its stack is left
 
   popall
   add rsp, 16         ; pop interrupt number
@@ -141,6 +143,9 @@ _INTERRUPT_COMMON 44
 _INTERRUPT_COMMON 45
 _INTERRUPT_COMMON 46
 _INTERRUPT_COMMON 47
+_INTERRUPT_COMMON 48   ; SCHEDULER YIELD
+_INTERRUPT_COMMON 49   ; TLB SHOOTDOWN
+_INTERRUPT_COMMON 50   ; SCHEDULER KICK
 
 load_idt:
 	lidt [rdi]
@@ -199,4 +204,7 @@ _interrupt_vector:
   _INT_NAME 45
   _INT_NAME 46
   _INT_NAME 47
+  _INT_NAME 48
+  _INT_NAME 49
+  _INT_NAME 50
   
\ No newline at end of file
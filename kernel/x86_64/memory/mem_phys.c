@@ -5,6 +5,11 @@
 #include "stdbool.h"
 #include "size_t.h"
 #include <neutrino/macros.h>
+#include <neutrino/lock.h>
+
+struct memory_physical pmm;
+
+static Lock pmm_lock = NewNamedLock("pmm");
 
 // === PRIVATE FUNCTIONS ========================
 
@@ -13,20 +18,20 @@
 // *Set a bit in the memory bitmap
 // @param bit the bit to set
 void pmm_map_set(int bit) {
-    pmm._map[bit / 32] |= (1 << (bit % 32));
+    pmm._map[bit / 32] |= (1u << (bit % 32));
 }
 
 // *Reset a bit in the memory bitmap
 // @param bit the bit to reset
 void pmm_map_unset(int bit) {
-    pmm._map[bit / 32] &= ~ (1 << (bit % 32));
+    pmm._map[bit / 32] &= ~ (1u << (bit % 32));
 }
 
 // *Get the value of the memory bitmap at the position [bit]
 // @param bit the bit to get the value from
 // @return true if the bit is set, false otherwise
-BlockState unoptimized pmm_map_get(int bit) {
-    return (pmm._map[bit / 32] & (1 << (bit % 32)));
+BlockState pmm_map_get(int bit) {
+    return (pmm._map[bit / 32] & (1u << (bit % 32)));
 }
 
 // *Find the first free slot in the memory starting from the specified block, and return it
@@ -36,7 +41,7 @@ BlockPosition pmm_map_first_free_starting_from(BlockPosition from_block) {
 	for (BlockPosition i= from_block; i < pmm.total_blocks/32; i++)
 		if (pmm._map[i] != 0xffffffff)
 			for (int j=0; j<32; j++) {		//! test each bit in the dword
- 				if (!(pmm._map[i] & 1 << j)) return i*4*8+j;
+ 				if (!(pmm._map[i] & 1u << j)) return i*4*8+j;
 			}
  
 	return BLOCKPOSITION_INVALID;
@@ -166,7 +171,7 @@ void pmm_print_memory_map(uint64_t base_addr, size_t size) {
 }
 
 // *Throw a fatal exception. This should be raised when out of physical memory
-void inline pmm_fatal() {
+static void pmm_fatal() {
 	ks.fatal(FatalError(OUT_OF_MEMORY, "Out of physical memory!"));
 }
 
@@ -223,10 +228,20 @@ void init_pmm(MemoryPhysicalRegion* entries, uint32_t size) {
 // *Allocate a physical memory block and return the physical address of the assigned region
 // @return the physical address of the assigned block
 uintptr_t pmm_alloc() {
-	if (pmm.used_blocks >= pmm.usable_blocks) pmm_fatal();
+	uintptr_t frame = pmm_try_alloc();
+	if (frame == nullptr) pmm_fatal();
+
+	return frame;
+}
+
+// *Allocate a physical memory block, leaving the out of memory condition to the caller
+// @return the physical address of the assigned block, or nullptr if the physical memory is exhausted
+uintptr_t pmm_try_alloc() {
+	LockRetain(pmm_lock);
+	if (pmm.used_blocks >= pmm.usable_blocks) return nullptr;
 	
 	uint32_t block = pmm_map_first_free();
-	if (block == -1) pmm_fatal();
+	if (block == -1) return nullptr;
 	
 	pmm_map_set(block);
 	pmm_update_blocks(+1);
@@ -245,6 +260,7 @@ uintptr_t pmm_alloc_zero() {
 // *Free a physical memory block
 // @param addr the address of the physical memory block to free
 void pmm_free(uintptr_t addr) {
+	LockRetain(pmm_lock);
 	uint32_t p = (uint32_t)addr;
 	uint32_t block = Align(p);
 
@@ -256,6 +272,7 @@ void pmm_free(uintptr_t addr) {
 // @param size the number of physical memory blocks to allocate
 // @return the physical address of the assigned block
 uintptr_t pmm_alloc_series(size_t size) {
+	LockRetain(pmm_lock);
 	if (pmm.used_blocks + size >= pmm.usable_blocks) pmm_fatal();
 
 	uint32_t block = pmm_map_first_free_series(size);
@@ -271,6 +288,7 @@ uintptr_t pmm_alloc_series(size_t size) {
 // @param size the number of physical memory blocks to free
 // @param addr the address of the physical memory block to free
 void pmm_free_series(uintptr_t addr, size_t size) {
+	LockRetain(pmm_lock);
 	uint32_t p = (uint32_t)addr;
 	uint32_t block = Align(p);
 
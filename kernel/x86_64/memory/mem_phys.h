@@ -47,10 +47,11 @@ struct memory_physical {
     uint64_t _map_size;
 };
 
-struct memory_physical pmm;
+extern struct memory_physical pmm;
 
 void init_pmm(MemoryPhysicalRegion* entries, uint32_t size);
 uintptr_t pmm_alloc(); 
+uintptr_t pmm_try_alloc();
 uintptr_t pmm_alloc_zero(); 
 void pmm_free(uintptr_t addr);
 uintptr_t pmm_alloc_series(size_t size); 
@@ -4,30 +4,46 @@
 #include "../smp.h"
 #include "../cpuid.h"
 #include "../arch.h"
+#include "../interrupts.h"
+#include "../device/apic.h"
 #include "kernel/common/kservice.h"
 #include "kernel/common/memory/memory.h"
+#include "kernel/common/spinlock.h"
 #include <stdbool.h>
 #include <libs/limine/stivale2.h>
 #include <size_t.h>
 #include <liballoc.h>
 #include <neutrino/lock.h>
 
+struct memory_virtual vmm;
+
 // === PRIVATE FUNCTIONS ========================
 
 void vmm_map_page_impl(PageTable* table_addr, uintptr_t phys_addr, uintptr_t virt_addr, PageProperties prop);
 
-Lock vmm_lock = NewLock;
+McsLock vmm_lock = NewNamedMcsLock("vmm");
+
+#define VMAL_SIZE   0x40000000      // 1GB of the pml4 entry, which is shared by every page table
+
+#define VMAL_PAGES  (VMAL_SIZE / PAGE_SIZE)
+
+static Lock vmal_lock = NewNamedLock("large allocations");
+static uint64_t vmal_bitmap[VMAL_PAGES / 64];  // bit n is set when page n of the area is taken, guard pages included
+static size_t vmal_hint = 0;                    // every page below the hint is taken
+
+static TicketLock tlb_lock = NewNamedTicketLock("tlb shootdown");
+static volatile uint32_t tlb_pending = 0;       // CPUs that still have to acknowledge the current shootdown
 
 // -- Utilities ---------------------------------
 
-void unoptimized vmm_reload_tlb(uintptr_t addr) {
-       asm volatile("invlpg (%0)" ::"r" (addr) : "memory");
+void vmm_reload_tlb(uintptr_t addr) {
+    asm volatile("invlpg (%0)" ::"r" (addr) : "memory");
 }
 
 // *Refresh paging by reloading the CR3 register
-void unoptimized vmm_reload_cr3() {
-    asm volatile("mov %%cr3, %%rax" : : );
-    asm volatile("mov %%rax, %%cr3" : : );
+void vmm_reload_cr3() {
+    uint64_t cr3;
+    asm volatile("mov %%cr3, %0; mov %0, %%cr3" : "=r"(cr3) : : "memory");
 }
 
 // *Get the recurse link for the active page table
@@ -58,7 +74,7 @@ PageTable* vmm_get_entry(PageTable* table, uint64_t entry) {
 // @param entry the index of the entry to be added
 // @param prop the properties of the page entry
 // @return the address of the newly created entry
-PageTable* unoptimized vmm_create_entry(PageTable* table, uint64_t entry, PageProperties prop) {
+PageTable* vmm_create_entry(PageTable* table, uint64_t entry, PageProperties prop) {
     PageTable* pt = (PageTable*)get_mem_address(pmm_alloc());
     table->entries[entry] = page_create(get_rmem_address((uintptr_t)pt), prop);
     if (vmm.initialized) memory_set((uint8_t*)get_perm_address(get_rmem_address((uintptr_t)pt)), 0, PAGE_SIZE);
@@ -73,7 +89,7 @@ PageTable* unoptimized vmm_create_entry(PageTable* table, uint64_t entry, PagePr
 // @param entry the index of the entry to be added
 // @param prop the properties of the page entry
 // @return the address of the existing table or the newly created table
-PageTable* unoptimized vmm_get_or_create_entry(PageTable* table, uint64_t entry, PageProperties prop) {
+PageTable* vmm_get_or_create_entry(PageTable* table, uint64_t entry, PageProperties prop) {
     if (IS_PRESENT(table->entries[entry])) {
         return (PageTable*)get_mem_address(GET_PHYSICAL_ADDRESS(table->entries[entry]));
     } else {
@@ -154,7 +170,7 @@ int64_t vmm_find_table_free_series(PageTable* table, size_t size){
     return -1;
 }
 
-PageTable* unoptimized vmm_get_table_address(PageTable* table_addr, uintptr_t virt_addr, uint16_t depth) {
+PageTable* vmm_get_table_address(PageTable* table_addr, uintptr_t virt_addr, uint16_t depth) {
     if (depth == 0) return table_addr;
     if (depth > 3) depth = 3;
 
@@ -209,7 +225,7 @@ void vmm_free_if_necessary_tables(PageTable* table, uint64_t unmapped_addr) {
     vmm_free_if_necessary_table(pdpt, table, path.pl4);
 }
 
-PageTable* unoptimized vmm_get_most_nested_table(PageTable* table_addr, uintptr_t virt_addr, PageProperties prop) {
+PageTable* vmm_get_most_nested_table(PageTable* table_addr, uintptr_t virt_addr, PageProperties prop) {
     PagingPath path = GetPagingPath(virt_addr);
     PagingPath tpath = GetPagingPath((uintptr_t)table_addr);
     bool isRecursive = tpath.pl4 == RECURSE_ACTIVE || tpath.pl4 == RECURSE_OTHER;
@@ -274,7 +290,7 @@ void vmm_mirror_physical_memory(PageTable* table) {
     }
 }
 
-void unoptimized vmm_map_kernel_region(struct memory_physical* phys, PageTable* page) {
+void vmm_map_kernel_region(struct memory_physical* phys, PageTable* page) {
     for (int ind = 0; ind < phys->regions_count; ind++) {
         if (phys->regions[ind].type != MEMORY_REGION_KERNEL) continue;
 
@@ -291,16 +307,47 @@ void unoptimized vmm_map_kernel_region(struct memory_physical* phys, PageTable*
 
 // --- Mapping and unmapping --------------------
 
-void unoptimized vmm_map_page_impl(PageTable* table_addr, uintptr_t phys_addr, uintptr_t virt_addr, PageProperties prop) {
-    LockRetain(vmm_lock);
+void vmm_map_page_impl(PageTable* table_addr, uintptr_t phys_addr, uintptr_t virt_addr, PageProperties prop) {
+    McsRetainIrq(vmm_lock);
     PagingPath path = GetPagingPath(virt_addr);
     PageTable* pt = vmm_get_most_nested_table(table_addr, virt_addr, prop);
 
     pt->entries[path.pt] = page_create(phys_addr, prop);
 }
 
+// *Read a 32 bit word of a space the way user mode would see it: every level of the translation must be present
+// *and allow user access. The word is read through the physical memory mirror with the vmm locked, so the page
+// *can't be unmapped meanwhile and a missing page never faults in the kernel
+// @param table the physical address of the pml4 table
+// @param virt_addr the virtual address of the word, 4 bytes aligned
+// @param value the read word, set on success
+// @return true if user mode can read the address, false otherwise
+bool vmm_read_user_u32(PageTable* table, uintptr_t virt_addr, uint32_t* value) {
+    McsRetainIrq(vmm_lock);
+    PagingPath path = GetPagingPath(virt_addr);
+    uint64_t indexes[4] = {path.pl4, path.dpt, path.pd, path.pt};
+    uint64_t page_sizes[4] = {0, HUGE_PAGE_SIZE, 0x200000, PAGE_SIZE};
+    PageTable* level = (PageTable*)get_mem_address((uintptr_t)table);
+
+    for (size_t i = 0; i < 4; i++) {
+        PageTableEntry entry = level->entries[indexes[i]];
+        if (!IS_PRESENT(entry) || !IS_USERSPACE(entry)) return false;
+
+        uintptr_t phys = entry & ADDRESS_MASK & ~NO_EXECUTE_BIT_OFFSET;
+        if (i == 3 || (i > 0 && IS_HUGE(entry))) {     // 1GB and 2MB pages end the walk early
+            phys = (phys & ~(page_sizes[i] - 1)) + (virt_addr & (page_sizes[i] - 1));
+            *value = __atomic_load_n((volatile uint32_t*)get_mem_address(phys), __ATOMIC_ACQUIRE);
+            return true;
+        }
+
+        level = (PageTable*)get_mem_address(phys);
+    }
+
+    return false;
+}
+
 bool vmm_unmap_page_impl(PageTable* table_addr, uintptr_t virt_addr) {
-    LockRetain(vmm_lock);
+    McsRetainIrq(vmm_lock);
     PageTable* pt = vmm_get_most_nested_table(table_addr, virt_addr, PageKernelWrite);
 
     if (pt == nullptr) return false;
@@ -311,7 +358,7 @@ bool vmm_unmap_page_impl(PageTable* table_addr, uintptr_t virt_addr) {
     return true;
 }
 
-uintptr_t unoptimized vmm_find_free_heap_series(size_t size, uintptr_t heap_base, PageProperties prop) {
+uintptr_t vmm_find_free_heap_series(size_t size, uintptr_t heap_base, PageProperties prop) {
     PageTable* pl4_addr = GetRecursiveAddress(RECURSE_ACTIVE, RECURSE_ACTIVE, RECURSE_ACTIVE, RECURSE_ACTIVE, GET_PL4_INDEX(heap_base));
     
     for (int dpt = 0; dpt < 512; dpt++) {
@@ -346,6 +393,127 @@ uintptr_t unoptimized vmm_find_free_heap_series(size_t size, uintptr_t heap_base
     return nullptr;
 }
 
+// --- TLB shootdown ----------------------------
+
+// *Flush the TLB of every other CPU, waiting for all of them to be done. Callers may have interrupts enabled or
+// *disabled: they're disabled during the shootdown, and a waiting CPU serves the requests itself.
+// *Must be called without holding locks that other CPUs could be spinning on with interrupts disabled
+void vmm_tlb_shootdown() {
+    uint32_t count = get_cpu_count();
+    if (count <= 1) return;
+
+    // CPUs waiting for their turn keep serving the requests, so that concurrent shootdowns can't deadlock
+    bool enabled = interrupts_save();
+    while (!ticket_try_lock(&tlb_lock)) {
+        vmm_tlb_service();
+        asm volatile("pause");
+    }
+
+    Cpu* self = get_current_cpu();
+    tlb_pending = count - 1;
+    for (uint32_t i = 0; i < count; i++) {
+        if (i != self->id) get_cpu(i)->tlb_flush = true;
+    }
+
+    // the page table changes and the requests must be visible before the other CPUs are interrupted
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    apic_broadcast_ipi(TLB_SHOOTDOWN_IRQ);
+    while (tlb_pending > 0) {
+        vmm_tlb_service();
+        asm volatile("pause");
+    }
+
+    ticket_unlock(&tlb_lock);
+    interrupts_restore(enabled);
+}
+
+// *Flush the TLB of the current CPU if a shootdown was requested to it
+void vmm_tlb_service() {
+    Cpu* cpu = get_current_cpu();
+    if (!cpu->tlb_flush) return;
+
+    cpu->tlb_flush = false;
+    vmm_reload_cr3();
+    __atomic_fetch_sub(&tlb_pending, 1, __ATOMIC_SEQ_CST);
+}
+
+// --- Large allocations ------------------------
+
+// *Take [pages] contiguous pages of the large allocations area, the first free ones found from the hint.
+// *The bookkeeping is a static bitmap, so that large allocations never go through the heap
+// @param pages the number of pages of the range
+// @return the base of the range, or nullptr if the area is exhausted
+uintptr_t vmm_large_range_take(size_t pages) {
+    uintptr_t base = nullptr;
+    size_t run = 0;
+
+    lock(&vmal_lock);
+    for (size_t page = vmal_hint; page < VMAL_PAGES; page++) {
+        // full words are skipped at once while no free run is in progress
+        if (run == 0 && page % 64 == 0 && vmal_bitmap[page / 64] == ~0ull) {
+            page += 63;
+            continue;
+        }
+
+        if (vmal_bitmap[page / 64] & (1ull << (page % 64))) {
+            run = 0;
+            continue;
+        }
+        if (++run < pages) continue;
+
+        size_t first = page + 1 - pages;
+        for (size_t p = first; p <= page; p++) vmal_bitmap[p / 64] |= (1ull << (p % 64));
+        if (first == vmal_hint) vmal_hint = page + 1;
+
+        base = VMAL_OFFSET + first * PAGE_SIZE;
+        break;
+    }
+    unlock(&vmal_lock);
+
+    return base;
+}
+
+// *Give [pages] pages at [base] back to the large allocations area
+// @param base the base of the range
+// @param pages the number of pages of the range
+void vmm_large_range_give(uintptr_t base, size_t pages) {
+    size_t first = (base - VMAL_OFFSET) / PAGE_SIZE;
+
+    lock(&vmal_lock);
+    for (size_t p = first; p < first + pages; p++) vmal_bitmap[p / 64] &= ~(1ull << (p % 64));
+    if (first < vmal_hint) vmal_hint = first;
+    unlock(&vmal_lock);
+}
+
+// *Unmap [blocks] pages of the large allocations area, returning each physical block to the PMM.
+// *Intermediate page tables are kept, since they are shared by every page table
+// @param addr the virtual address of the first page
+// @param blocks the number of pages to unmap
+void vmm_large_unmap(uintptr_t addr, size_t blocks) {
+    if (blocks == 0) return;
+
+    // the pages are unmapped first, and their blocks are freed only once no CPU can reach them
+    for (size_t i = 0; i < blocks; i++) {
+        uintptr_t virt_addr = addr + (i*PAGE_SIZE);
+        PagingPath path = GetPagingPath(virt_addr);
+        PageTableEntry* entry = (PageTableEntry*)GetRecursiveAddress(RECURSE_ACTIVE, path.pl4, path.dpt, path.pd, path.pt);
+
+        page_clear_bit(entry, PRESENT_BIT_OFFSET);
+        vmm_reload_tlb(virt_addr);
+    }
+
+    vmm_tlb_shootdown();
+
+    for (size_t i = 0; i < blocks; i++) {
+        uintptr_t virt_addr = addr + (i*PAGE_SIZE);
+        PagingPath path = GetPagingPath(virt_addr);
+        PageTableEntry* entry = (PageTableEntry*)GetRecursiveAddress(RECURSE_ACTIVE, path.pl4, path.dpt, path.pd, path.pt);
+
+        if (GET_PHYSICAL_ADDRESS(*entry) != 0) pmm_free(GET_PHYSICAL_ADDRESS(*entry));
+        *entry = 0;
+    }
+}
+
 // === PUBLIC FUNCTIONS =========================
 
 void init_vmm() {
@@ -366,6 +534,9 @@ void init_vmm() {
     vmm_mirror_physical_memory(kernel_pml4);
     vmm_map_physical_regions(kernel_pml4);
 
+    // the large allocations area is created now, so that every page table cloned from this one shares it
+    kernel_pml4->entries[GET_PL4_INDEX(VMAL_OFFSET)] = page_create(get_rmem_address((uintptr_t)vmm_new_table()), PageKernelWrite);
+
     // map the physical memory bitmap 
     for (int i = 0; i * PAGE_SIZE < PHYSMEM_MAP_SIZE; i++) 
         vmm_map_page_impl(kernel_pml4, get_rmem_address(PHYSMEM_MAP_BASE + (i * PAGE_SIZE)), PHYSMEM_MAP_BASE + (i * PAGE_SIZE), (PageProperties){true, false});
@@ -379,12 +550,13 @@ void init_vmm() {
     ks.log("VMM has been initialized.");
 }
 
-void unoptimized init_vmm_on_ap(struct stivale2_smp_info* info) {
-    ks.log("Initializing VMM on CPU #%u...", info->processor_id);
+void init_vmm_on_ap(struct stivale2_smp_info* info) {
+    uint32_t cpu_id = (uint32_t)info->extra_argument;
+    ks.log("Initializing VMM on CPU #%u...", cpu_id);
 
     // prepare a pml4 table for the kernel address space
     PageTable* kernel_pml4 = vmm_new_table();
-    ks.dbg("New pml4 created at %x for CPU #%u", kernel_pml4, info->processor_id);
+    ks.dbg("New pml4 created at %x for CPU #%u", kernel_pml4, cpu_id);
     
     // clone 256-511 entries
     ks.dbg("Cloning BSP page table...");
@@ -410,7 +582,7 @@ void unoptimized init_vmm_on_ap(struct stivale2_smp_info* info) {
     
     // give CR3 the kernel pml4 address
     ks.dbg("Preparing to load pml4... %x %x", kernel_pml4, get_rmem_address((uintptr_t)kernel_pml4));
-    get_cpu(info->processor_id)->page_table = (PageTable*)get_rmem_address((uintptr_t)kernel_pml4);
+    get_cpu(cpu_id)->page_table = (PageTable*)get_rmem_address((uintptr_t)kernel_pml4);
     write_cr3(get_rmem_address((uintptr_t)kernel_pml4));
     ks.log("VMM has been initialized.");
 }
@@ -420,7 +592,7 @@ void unoptimized init_vmm_on_ap(struct stivale2_smp_info* info) {
 // @param phys_addr the physical address to map the virtual address to
 // @param virt_addr the virtual address to map the physical address to
 // @param prop the properties of the page entry
-void unoptimized vmm_map_page(PageTable* table, uintptr_t phys_addr, uintptr_t virt_addr, PageProperties prop) {  
+void vmm_map_page(PageTable* table, uintptr_t phys_addr, uintptr_t virt_addr, PageProperties prop) {  
     if (read_cr3() == (uintptr_t)table || table == 0) {               //  cr3 is the given table physical address
         vmm_map_page_impl((PageTable*)vmm_get_active_recurse_link(), phys_addr, virt_addr, prop);
     
@@ -473,7 +645,7 @@ uintptr_t vmm_allocate_memory(PageTable* table, size_t blocks, PageProperties pr
     return get_mem_address(phys_addr);
 }
 
-uintptr_t unoptimized vmm_allocate_heap(size_t blocks, bool user) {
+uintptr_t vmm_allocate_heap(size_t blocks, bool user) {
     uintptr_t heap_base = (user ? USER_HEAP_OFFSET : HEAP_OFFSET);
     PageProperties prop = (PageProperties) {
         .cache_disable = true,
@@ -481,10 +653,11 @@ uintptr_t unoptimized vmm_allocate_heap(size_t blocks, bool user) {
         .writable = true
     };
 
-    lock(&vmm_lock);
+    McsNode node;
+    bool enabled = mcs_lock_irqsave(&vmm_lock, &node);
     uintptr_t phys_addr = pmm_alloc_series(blocks);
     uintptr_t virt_addr = vmm_find_free_heap_series(blocks, heap_base, prop);
-    unlock(&vmm_lock);
+    mcs_unlock_irqrestore(&vmm_lock, &node, enabled);
 
     for (size_t i = 0; i < blocks; i++) 
         vmm_map_page(0, phys_addr + (i*PHYSMEM_BLOCK_SIZE), virt_addr + (i*PHYSMEM_BLOCK_SIZE), prop);
@@ -506,6 +679,41 @@ uintptr_t unoptimized vmm_allocate_heap(size_t blocks, bool user) {
     return virt_addr;
 }
 
+// *Allocate [blocks] physical blocks, not necessarily contiguous, and map them to a contiguous range
+// *of the kernel large allocations area. The page after the range is left unmapped, so that an overrun
+// *faults rather than corrupting the next allocation
+// @param blocks the number of blocks to allocate
+// @return the virtual address of the allocated memory, or nullptr if the area or the physical memory is exhausted
+uintptr_t vmm_allocate_large(size_t blocks) {
+    uintptr_t virt_addr = vmm_large_range_take(blocks + 1);
+    if (virt_addr == nullptr) {
+        ks.err("Large allocations area exhausted (%u blocks requested)", blocks);
+        return nullptr;
+    }
+
+    for (size_t i = 0; i < blocks; i++) {
+        uintptr_t frame = pmm_try_alloc();
+        if (frame == nullptr) {
+            ks.err("Out of physical memory (%u of %u blocks allocated)", i, blocks);
+            vmm_large_unmap(virt_addr, i);
+            vmm_large_range_give(virt_addr, blocks + 1);
+            return nullptr;
+        }
+
+        vmm_map_page(0, frame, virt_addr + (i*PAGE_SIZE), PageKernelWrite);
+    }
+
+    return virt_addr;
+}
+
+// *Unmap a memory area allocated with vmm_allocate_large(), returning each physical block to the PMM
+// @param addr the virtual address of the memory area
+// @param blocks the number of blocks of the memory area
+void vmm_free_large(uintptr_t addr, size_t blocks) {
+    vmm_large_unmap(addr, blocks);
+    vmm_large_range_give(addr, blocks + 1);     // along with its guard page
+}
+
 // *Unmap a memory area given the virtual address and the blocks. Works with either an offline page table or an active one
 // @param table the table to unmap the address from. 0 if current
 // @param addr the virtual address to unmap
@@ -533,7 +741,7 @@ uintptr_t vmm_map_mmio(uintptr_t mmio_addr, size_t blocks) {
 
 #include <liballoc.h>
 
-PageTable* unoptimized NewPageTable() {
+PageTable* NewPageTable() {
     PageTable* p = (PageTable*)vmm_allocate_memory(get_current_cpu()->page_table, 1, PageKernelWrite);
     memory_set((uint8_t*)p, 0, PAGE_SIZE);
 
@@ -546,12 +754,12 @@ PageTable* unoptimized NewPageTable() {
     return (PageTable*)get_rmem_address((uintptr_t)p);
 }
 
-void unoptimized DestroyPageTable(PageTable* page_table) {
+void DestroyPageTable(PageTable* page_table) {
     write_cr3((uintptr_t)get_current_cpu()->page_table);
     vmm_free_memory(get_current_cpu()->page_table, get_mem_address((uintptr_t)page_table), 1);
 } 
 
-void unoptimized vmm_switch_space(PageTable* page_table) {
+void vmm_switch_space(PageTable* page_table) {
     write_cr3((uint64_t)page_table);
     vmm_reload_cr3();
 }
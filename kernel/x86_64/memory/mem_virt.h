@@ -10,16 +10,22 @@ struct memory_virtual {
     bool initialized;
 };
 
-struct memory_virtual vmm;
+extern struct memory_virtual vmm;
 
 void init_vmm();
 void init_vmm_on_ap(struct stivale2_smp_info* info);
 
 bool vmm_unmap_page(PageTable* table, uintptr_t virt_addr);
+uintptr_t vmm_virt_to_phys(PageTable* table, uintptr_t virt);
+bool vmm_read_user_u32(PageTable* table, uintptr_t virt_addr, uint32_t* value);
 void vmm_map_page(PageTable* table, uintptr_t phys_addr, uintptr_t virt_addr, PageProperties prop);
 
 uintptr_t vmm_allocate_memory(PageTable* table, size_t blocks, PageProperties prop);
 uintptr_t vmm_allocate_heap(size_t blocks, bool user);
+uintptr_t vmm_allocate_large(size_t blocks);
+void vmm_free_large(uintptr_t addr, size_t blocks);
+void vmm_tlb_shootdown();
+void vmm_tlb_service();
 uintptr_t vmm_map_mmio(uintptr_t mmio_addr, size_t blocks);
 bool vmm_free_memory(PageTable* table, uintptr_t addr, size_t blocks);
 
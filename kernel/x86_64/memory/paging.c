@@ -7,30 +7,30 @@
 // *Check if paging is enabled
 // @return true if paging is enabled, false otherwise
 bool is_paging_enabled() {
-    uint32_t result;
-    __asm__("mov %%cr0, %%rbx" : "=b" (result) : );
-    return (result >> 31) == 1;
+    uint64_t result;
+    asm volatile("mov %%cr0, %0" : "=r" (result));
+    return (result >> 31) & 1;
 }
 
 // *Disable paging by setting CR0's PG to 0
 void disable_paging() {
-    uint32_t result;
-    __asm__("mov %%cr0, %%rbx" : "=b" (result) : );
-    __asm__("mov %%rbx, %%cr0" :  : "b" (~(1 << 31) & result));
+    uint64_t result;
+    asm volatile("mov %%cr0, %0" : "=r" (result));
+    asm volatile("mov %0, %%cr0" : : "r" (~(1ull << 31) & result) : "memory");
 }
 
 // *Read the current value of the CR3 register (the physical address of the active PageTable)
 // @return the current value of the CR3 register
-uint64_t unoptimized read_cr3() {
+uint64_t read_cr3() {
     uint64_t value;
-    __asm__("mov %%cr3, %%rax" : "=a"(value)); 
+    asm volatile("mov %%cr3, %0" : "=r"(value));
     return value;
 }
 
 // *Write the given value to the CR3 register
 // @param value the value to write to CR3 register
 void write_cr3(uint64_t value) {
-    asm volatile("mov %0, %%cr3" : : "r"(value));
+    asm volatile("mov %0, %%cr3" : : "r"(value) : "memory");
 }
 
 PageTableEntry page_create(uint64_t addr, PageProperties prop) {
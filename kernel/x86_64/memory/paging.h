@@ -72,8 +72,8 @@ void disable_paging();
 uint64_t read_cr3();
 void write_cr3(uint64_t value);
 
-inline void page_set_bit(PageTableEntry* page, uint64_t offset) { *page |= (offset); }
-inline void page_clear_bit(PageTableEntry* page, uint64_t offset) { *page &= ~(offset); }
+static inline void page_set_bit(PageTableEntry* page, uint64_t offset) { *page |= (offset); }
+static inline void page_clear_bit(PageTableEntry* page, uint64_t offset) { *page &= ~(offset); }
 
 PageTableEntry page_create(uint64_t addr, PageProperties prop);
 PageTableEntry page_pdpt_huge(uintptr_t addr, PageProperties prop);
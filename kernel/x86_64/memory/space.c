@@ -1,5 +1,6 @@
 #include "space.h"
 #include "mem_virt.h"
+#include "mem_phys.h"
 #include "kernel/common/memory/space.h"
 #include "kernel/common/memory/memory.h"
 #include <liballoc.h>
@@ -14,27 +15,41 @@ Space* NewSpace() {
     Space* space = (Space*)kmalloc(sizeof(Space));
     space->lock = NewLock;
     space->page_table = NewPageTable();
+    space->refs = 1;
+    space->thread_stacks = 0;
+    space->memory_ranges = nullptr;
     return space;
 }
 
+// *Release a reference to a space. The memory ranges and the page table are freed with the last reference
+// @param space the space to release
 void DestroySpace(Space* space) {
-    if (space->memory_ranges != nullptr) {
-
-        MemoryRangeNode* node = space->memory_ranges;
-        while (node != nullptr) { // loop and free the memory ranges
-            vmm_free_memory(space->page_table, node->range.base, node->range.size);
-            kfree(node);
-            node = node->next;
-        }
-        
+    if (__atomic_sub_fetch(&space->refs, 1, __ATOMIC_ACQ_REL) > 0) return;
+
+    MemoryRangeNode* node = space->memory_ranges;
+    while (node != nullptr) { // loop and free the memory ranges
+        MemoryRangeNode* next = node->next;
+        vmm_free_memory(space->page_table, node->range.base, node->range.size);
+        kfree(node);
+        node = next;
     }
 
     DestroyPageTable(space->page_table);
     kfree(space);
 }
 
-void unoptimized space_switch(Space* space) {
-    LockRetain(space->lock);
+// *Take a new reference to a space, shared by the threads of a process
+// @param space the space to share
+// @return the same space
+Space* space_retain(Space* space) {
+    __atomic_add_fetch(&space->refs, 1, __ATOMIC_ACQ_REL);
+    return space;
+}
+
+// *Load the page table of a space on the current CPU. Called by the scheduler from the timer interrupt, so the
+// *space lock is not taken: the interrupted task may be holding it, and the page table of a space never changes
+// @param space the space of the task being resumed
+void space_switch(Space* space) {
     vmm_switch_space(space->page_table);
 }
 
@@ -58,17 +73,35 @@ void space_map(Space* space, uintptr_t phys_addr, uintptr_t virt_addr, size_t si
 }
 
 void space_unmap(Space* space, uintptr_t virt_addr) {
-    LockRetain(space->lock);
+    lock(&space->lock);
 
-    // find the corresponding node and free the associated memory range
-    MemoryRangeNode* node = space->memory_ranges;
-    while (node != nullptr) { 
-        if (node->range.base != virt_addr) {
-            node = node->next;
-            continue;
-        }
-        
-        vmm_free_memory(space->page_table, node->range.base, node->range.size);
-        kfree(node);        
+    // find the corresponding node and unlink it
+    MemoryRangeNode** link = &space->memory_ranges;
+    while (*link != nullptr && (*link)->range.base != virt_addr) link = &(*link)->next;
+
+    MemoryRangeNode* node = *link;
+    if (node == nullptr) {
+        unlock(&space->lock);
+        return;
     }
+
+    *link = node->next;
+    uintptr_t phys_addr = vmm_virt_to_phys(space->page_table, node->range.base);
+    for (size_t i = 0; i < node->range.size; i++) 
+        vmm_unmap_page(space->page_table, node->range.base + (i*PAGE_SIZE));
+    unlock(&space->lock);
+
+    // other threads of the space may have cached the range, the frames are freed once no CPU can reach them
+    vmm_tlb_shootdown();
+    pmm_free_series(phys_addr, node->range.size);
+    kfree(node);
+}
+
+// *Read a word of a space, only if user mode can read it. Safe with locks held: a missing page never faults
+// @param space the space to read the word from
+// @param virt_addr the virtual address of the word, 4 bytes aligned
+// @param value the read word, set on success
+// @return true if the address is mapped in the space and accessible from user mode, false otherwise
+bool space_read_user_u32(Space* space, uintptr_t virt_addr, uint32_t* value) {
+    return vmm_read_user_u32(space->page_table, virt_addr, value);
 }
@@ -8,8 +8,10 @@
 #include "kernel/common/memory/memory.h"
 
 struct __space {
-    Lock lock;
-    PageTable* page_table;
+    Lock lock;                      // serializes the mappings and the thread stack slots, never taken by space_switch()
+    PageTable* page_table;          // set on creation, read without the lock
+    volatile uint32_t refs;         // tasks sharing the space, it's destroyed along with the last one
+    uint64_t thread_stacks;         // bit n is set when the thread stack slot n is in use
 
     MemoryRangeNode* memory_ranges;
 };
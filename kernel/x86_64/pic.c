@@ -15,7 +15,7 @@ uint16_t pic_read_reg(uint32_t ocw3) {
 // *Small helper to send data to the desired pic port and wait
 // @param port the pic port to send data to
 // @param data the data to send
-void inline pic_send(unsigned short port, uint8_t data) {
+static inline void pic_send(unsigned short port, uint8_t data) {
     port_byte_out(port, data);
     pic_wait();
 }
@@ -17,7 +17,7 @@
 #define PIC_READ_IRR        0x0a
 #define PIC_EOI             0x20
 
-void inline pic_wait() {
+static inline void pic_wait() {
     do {
         asm volatile("jmp 1f\n\t"     
                      "1:\n\t"         
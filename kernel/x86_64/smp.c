@@ -13,18 +13,21 @@
 #include <_null.h>
 #include <stdbool.h>
 
+struct smp_t smp;
+
 static volatile bool cpu_started = false;
 
 // === PRIVATE FUNCTIONS ========================
 
-void unoptimized start_cpu(struct stivale2_smp_info* smp_info) {
+void start_cpu(struct stivale2_smp_info* smp_info) {
     disable_interrupts();
+    uint32_t cpu_id = (uint32_t)smp_info->extra_argument;
 
-    init_gdt_on_ap(smp_info->processor_id);
+    init_gdt_on_ap(cpu_id);
     init_idt();
 
     init_vmm_on_ap(smp_info);
-    init_tss(get_cpu(((struct stivale2_smp_info*)get_mem_address((uintptr_t)smp_info))->processor_id));
+    init_tss(get_cpu(cpu_id));
     
     init_sse();
     map_apic_on_ap();
@@ -33,53 +36,54 @@ void unoptimized start_cpu(struct stivale2_smp_info* smp_info) {
     if (has_hpet()) vmm_map_mmio(get_rmmio_address(hpet.base), 1);
     init_apic_timer();
 
-    cpu_started = true;
+    __atomic_store_n(&cpu_started, true, __ATOMIC_RELEASE);
 
+    // the timer interrupt takes the CPU into the scheduler as soon as it is ready
     enable_interrupts();
     for (;;) asm volatile("hlt");
 }
 
 // === PUBLIC FUNCTIONS =========================
 
-void unoptimized init_smp(struct stivale2_struct_tag_smp *smp_struct) {
+void init_smp(struct stivale2_struct_tag_smp *smp_struct) {
     ks.log("Initializing other CPUs...");
     ks.dbg("Found %i CPUs. x2APIC is %c", smp_struct->cpu_count, smp_struct->flags & 1 ? "enabled" : "disabled");
 
     apic.x2apic_enabled = smp_struct->flags & 1;
 
-    // todo: remove single-core force
-    if (smp_struct->cpu_count > 1) {
-        ks.warn("Multi-core is not supported yet. Using only one CPU.");
-        smp.cpu_count = 1;
-    
-    } else {
-
-        smp.cpu_count = (smp_struct->cpu_count > MAX_CPU ? MAX_CPU : smp_struct->cpu_count);
-
-        // save cpus
-        for (int i = 0; i < smp.cpu_count; i++) {
-            struct stivale2_smp_info cpu_info = smp_struct->smp_info[i];
-            // skip the bsp
-            if (cpu_info.lapic_id == smp_struct->bsp_lapic_id) continue;               
-            
-            ks.dbg("cpu id: %d lapic id: %d", cpu_info.processor_id, cpu_info.lapic_id);
-            smp.cpus[i].id = cpu_info.processor_id;
-            smp.cpus[i].lapic_id = cpu_info.lapic_id;
-            
-            // prepare the stack
-            smp.cpus[i].stack = (uint8_t*)pmm_alloc_series(CPU_STACK_SIZE/PHYSMEM_BLOCK_SIZE);
-            smp_struct->smp_info[i].target_stack = get_mem_address((uintptr_t)smp.cpus[i].stack) + CPU_STACK_SIZE;
-            smp.cpus[i].tss.rsp0 = (uint64_t)smp.cpus[i].stack;
-
-            // boot the ap
-            ks.log("Starting CPU #%d, stack at %x, trampoline at %x", i, smp_struct->smp_info[i].target_stack, (uint64_t)start_cpu);
-            smp_struct->smp_info[i].goto_address = (uint64_t)start_cpu;
-            
-            // wait for ap to boot up
-            while (!cpu_started);
-            ks.log("CPU #%d started successfully", i);
-            cpu_started = false;
-        }
+    if (smp_struct->cpu_count > MAX_CPU)
+        ks.warn("Found %u CPUs, only the first %u will be used.", smp_struct->cpu_count, MAX_CPU);
+
+    // the bsp is always CPU #0, the aps are numbered in the order they are found
+    smp.cpu_count = 1;
+    smp.cpus[0].lapic_id = smp_struct->bsp_lapic_id;
+    if (smp_struct->bsp_lapic_id < SMP_LAPIC_MAP_SIZE) smp.lapic_map[smp_struct->bsp_lapic_id] = 0;
+
+    for (uint64_t i = 0; i < smp_struct->cpu_count && smp.cpu_count < MAX_CPU; i++) {
+        struct stivale2_smp_info* cpu_info = &smp_struct->smp_info[i];
+        // skip the bsp
+        if (cpu_info->lapic_id == smp_struct->bsp_lapic_id) continue;
+        
+        uint32_t id = smp.cpu_count++;
+        ks.dbg("cpu id: %d lapic id: %d", id, cpu_info->lapic_id);
+        smp.cpus[id].id = id;
+        smp.cpus[id].lapic_id = cpu_info->lapic_id;
+        if (cpu_info->lapic_id < SMP_LAPIC_MAP_SIZE) smp.lapic_map[cpu_info->lapic_id] = id;
+        
+        // prepare the stack
+        smp.cpus[id].stack = (uint8_t*)pmm_alloc_series(CPU_STACK_SIZE/PHYSMEM_BLOCK_SIZE);
+        cpu_info->target_stack = get_mem_address((uintptr_t)smp.cpus[id].stack) + CPU_STACK_SIZE;
+        cpu_info->extra_argument = id;
+
+        // boot the ap
+        ks.log("Starting CPU #%d, stack at %x, trampoline at %x", id, cpu_info->target_stack, (uint64_t)start_cpu);
+        // the ap polls goto_address, the stack and the argument must be visible before it
+        __atomic_store_n(&cpu_info->goto_address, (uint64_t)start_cpu, __ATOMIC_RELEASE);
+        
+        // wait for ap to boot up
+        while (!__atomic_load_n(&cpu_started, __ATOMIC_ACQUIRE)) asm volatile("pause");
+        ks.log("CPU #%d started successfully", id);
+        cpu_started = false;
     }
 
     ks.log("%u CPUs initialized successfully.", smp.cpu_count);
@@ -88,7 +92,8 @@ void unoptimized init_smp(struct stivale2_struct_tag_smp *smp_struct) {
 
 // *Set the information about the BSP on startup
 // @param bsp_stack the stack of the bootstrap processor
-void unoptimized setup_bsp(uint8_t* bsp_stack) {
+void setup_bsp(uint8_t* bsp_stack) {
+    smp.cpu_count = 1;
     smp.cpus[0].id = 0;
     smp.cpus[0].lapic_id = 0;
     smp.cpus[0].stack = bsp_stack;
@@ -97,7 +102,7 @@ void unoptimized setup_bsp(uint8_t* bsp_stack) {
 // *Get the cpu info given the cpu id
 // @param id the cpu id to get the info from
 // @return the pointer to the cpu info structure
-Cpu* unoptimized get_cpu(uint32_t id) {
+Cpu* get_cpu(uint32_t id) {
     if (id != 0 && id >= smp.cpu_count) {
         ks.warn("Cannot find cpu with id %u", id);
         return (Cpu*)NULL;
@@ -114,17 +119,32 @@ Cpu* get_bootstrap_cpu() {
 
 // *Get the cpu info about the current processor
 // @return the pointer to the cpu info structure of the current processor
-Cpu* unoptimized get_current_cpu() {
-    uint32_t id = LapicIDCorrection(apic_read(lapic_id));
-
-    if (id >= 0 && id < smp.cpu_count)
-        return &(smp.cpus[id]);
-    else {
-        ks.warn("Cannot find cpu #%u", id);
-        return (Cpu*)nullptr;
-    }    
+Cpu* get_current_cpu() {
+    uint32_t lapic = LapicIDCorrection(apic_read(lapic_id));
+    if (lapic < SMP_LAPIC_MAP_SIZE) 
+        return &(smp.cpus[smp.lapic_map[lapic]]);
+
+    for (uint32_t i = 0; i < smp.cpu_count; i++) {
+        if (smp.cpus[i].lapic_id == lapic) return &(smp.cpus[i]);
+    }
+
+    ks.warn("Cannot find cpu with lapic id #%u", lapic);
+    return (Cpu*)nullptr;
 }
 
 size_t get_cpu_count() {
     return (size_t)smp.cpu_count;
 }
+
+// *Make a CPU run the scheduler as soon as possible. A CPU idling in MWAIT is woken up by the write to its
+// *need_resched word, any other CPU through a kick IPI, which unlike a timer interrupt charges no tick
+// @param id the id of the CPU
+void cpu_kick(uint32_t id) {
+    if (id >= smp.cpu_count) return;
+    Cpu* cpu = &smp.cpus[id];
+
+    // the store must be visible before polling is read, or a CPU starting to poll could miss it
+    __atomic_store_n(&cpu->tasks.need_resched, true, __ATOMIC_SEQ_CST);
+    if (!__atomic_load_n(&cpu->tasks.polling, __ATOMIC_SEQ_CST))
+        apic_send_ipi(cpu->lapic_id, SCHED_KICK_IRQ);
+}
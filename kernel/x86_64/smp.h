@@ -11,19 +11,32 @@ struct __cpu {
 
     uint8_t* stack;             // CPU stack
     uint8_t* stack_interrupt;   // CPU interrupt stack
+    uint8_t* stack_kernel;      // CPU stack used when interrupted in user mode (TSS.rsp0)
 
     PageTable* page_table;     // CPU page table physical address
     Tss tss;
 
+    struct {
+        uint32_t period;        // LAPIC timer counts in a scheduler tick (1ms)
+        uint64_t tsc_per_ms;    // time-stamp counter increments in a millisecond
+        uint8_t mode;           // current LAPIC timer mode
+    } timer;
+
+    volatile bool tlb_flush;    // a TLB shootdown was requested to the CPU
+    struct __context* simd_owner;   // context whose SIMD state was last loaded in the CPU registers
+
     struct __tasks tasks;
 };
 
+#define SMP_LAPIC_MAP_SIZE  256
+
 struct smp_t {
     uint32_t cpu_count;
     Cpu cpus[MAX_CPU];
+    uint8_t lapic_map[SMP_LAPIC_MAP_SIZE];   // CPU id of each xAPIC id
 };
 
-struct smp_t smp;
+extern struct smp_t smp;
 
 void init_smp(struct stivale2_struct_tag_smp*);
 Cpu* get_cpu(uint32_t id);
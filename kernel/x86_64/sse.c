@@ -32,33 +32,33 @@ bool has_avx() {
 }
 
 // *Enable SSE in the system. Must first check if SSE is available with has_sse()
-void unoptimized enable_sse() {
+void enable_sse() {
     uint64_t cr0, cr4;
-    __asm__("mov %%cr0, %0" : "=g" (cr0) : );
-    __asm__("mov %%cr4, %0" : "=g" (cr4) : );
+    asm volatile("mov %%cr0, %0" : "=r" (cr0));
+    asm volatile("mov %%cr4, %0" : "=r" (cr4));
 
     cr0 &= ~(1 << 2);       // clear CR0.EM bit
     cr0 |= (1 << 1);        // set CR0.MP bit
     cr4 |= (1 << 9);        // set CR4.OSFXSR bit
     cr4 |= (1 << 10);       // set CR4.OSXMMEXCPT bit
 
-    __asm__("mov %0, %%cr0" : : "r" (cr0));
-    __asm__("mov %0, %%cr4" : : "r" (cr4));
+    asm volatile("mov %0, %%cr0" : : "r" (cr0) : "memory");
+    asm volatile("mov %0, %%cr4" : : "r" (cr4) : "memory");
 }
 
 // *Enable XSAVE instruction in the system. Must first check if XSAVE is supported with has_xsave()
-void unoptimized enable_xsave() {
+void enable_xsave() {
     uint64_t cr4;
-    __asm__("mov %%cr4, %0" : "=g" (cr4) : );   
+    asm volatile("mov %%cr4, %0" : "=r" (cr4));
     cr4 |= (1 << 18);
-    __asm__("mov %0, %%cr4" : : "r" (cr4)); // enable XSAVE bit in CR4
+    asm volatile("mov %0, %%cr4" : : "r" (cr4) : "memory"); // enable XSAVE bit in CR4
     
-    __asm__("xsetbv" : : "a" (XCR0_X87_STATE | XCR0_ENABLE_SSE), "c" (0), "d" (0));
+    asm volatile("xsetbv" : : "a" (XCR0_X87_STATE | XCR0_ENABLE_SSE), "c" (0), "d" (0));
 }
 
 // *Enable AVX instruction set in the system. Must first check if AVX is supported with has_avx()
-void unoptimized enable_avx() {
-    __asm__("xsetbv" : : "a" (XCR0_X87_STATE | XCR0_ENABLE_SSE | XCR0_ENABLE_AVX), "c" (0), "d" (0));
+void enable_avx() {
+    asm volatile("xsetbv" : : "a" (XCR0_X87_STATE | XCR0_ENABLE_SSE | XCR0_ENABLE_AVX), "c" (0), "d" (0));
 }
 
 // === PUBLIC FUNCTIONS =========================
@@ -88,12 +88,12 @@ void init_sse() {
     _avx_save((uintptr_t)fpu_data);
 }
 
-void unoptimized save_sse_context(uint8_t* context) {
+void save_sse_context(uint8_t* context) {
     if (use_xsave) _avx_save((uintptr_t)context);
     else _sse_save((uintptr_t)context);
 }
 
-void unoptimized load_sse_context(uint8_t* context) {
+void load_sse_context(uint8_t* context) {
     if (use_xsave) _avx_load((uintptr_t)context);
     else _sse_load((uintptr_t)context);
 }
@@ -6,11 +6,25 @@
 #define XCR0_ENABLE_SSE (1 << 1)
 #define XCR0_ENABLE_AVX (1 << 2)
 
+#define CR0_TASK_SWITCHED   (1 << 3)
+
 // *Enable FPU (Floating Point Unit)
-inline void enable_fpu() {
+static inline void enable_fpu() {
     asm volatile("fninit");
 }
 
+// *Set CR0.TS, so that the next SIMD instruction raises a #NM exception
+static inline void simd_trap_enable() {
+    uint64_t cr0;
+    asm volatile("mov %%cr0, %0" : "=r" (cr0));
+    if (!(cr0 & CR0_TASK_SWITCHED)) asm volatile("mov %0, %%cr0" : : "r" (cr0 | CR0_TASK_SWITCHED) : "memory");
+}
+
+// *Clear CR0.TS, allowing SIMD instructions again
+static inline void simd_trap_disable() {
+    asm volatile("clts" ::: "memory");
+}
+
 static inline void _avx_save(uintptr_t addr) {
     asm volatile("xsave64 %0" : :  "m" (*(uint64_t*)addr), "d" (0xffffffff), "a" (0xffffffff) : "memory");
 }
@@ -20,11 +34,11 @@ static inline void _avx_load(uintptr_t addr) {
 }
 
 static inline void _sse_save(uintptr_t addr) {
-    asm volatile("fxsave %0" : : "m" (*(uint64_t*)addr));
+    asm volatile("fxsave %0" : "=m" (*(uint8_t(*)[512])addr) : : "memory");
 }
 
 static inline void _sse_load(uintptr_t addr) {
-    asm volatile("fxrstor %0" : : "m" (*(uint64_t*)addr));
+    asm volatile("fxrstor %0" : : "m" (*(const uint8_t(*)[512])addr) : "memory");
 }
 
 bool has_sse();
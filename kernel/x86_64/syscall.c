@@ -27,11 +27,14 @@ void init_syscall() {
     write_msr(SYSCALL_FLAG_MASK, 0xfffffffe);
 }
 
-void syscall_set_gs(uintptr_t addr) {
-    // write_msr(GS_BASE, addr);
-    write_msr(KERN_GS_BASE, addr);
+// *Set the GS base used by the syscall entry of the task being resumed
+// @param addr the address of the task Context
+// @param in_kernel true if the task is resumed in kernel mode (in the middle of a syscall), where swapgs was already done
+void syscall_set_gs(uintptr_t addr, bool in_kernel) {
+    write_msr(in_kernel ? GS_BASE : KERN_GS_BASE, addr);
+    write_msr(in_kernel ? KERN_GS_BASE : GS_BASE, 0);
 }
 
-uint64_t unoptimized syscall_handler(Registers* regs) {
+uint64_t syscall_handler(Registers* regs) {
     return syscall_execute((NeutrinoSyscall)regs->rax, (uintptr_t*)regs->rbx);
 }
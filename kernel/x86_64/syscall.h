@@ -1,5 +1,6 @@
 #pragma once
 #include <stdint.h>
+#include <stdbool.h>
 
 void init_syscall();
-void syscall_set_gs(uintptr_t addr);
+void syscall_set_gs(uintptr_t addr, bool in_kernel);
@@ -2,6 +2,8 @@
 #include "../sse.h"
 #include "../syscall.h"
 #include "../memory/mem_virt.h"
+#include "../smp.h"
+#include "../arch.h"
 #include "kernel/common/memory/memory.h"
 #include "kernel/common/tasks/context.h"
 #include "kernel/common/tasks/task.h"
@@ -15,12 +17,15 @@
 // === PUBLIC FUNCTIONS =========================
 
 // *Create a new Context
-Context* unoptimized NewContext() {
+Context* NewContext() {
     Context* context = (Context*)kmalloc(sizeof(Context) + get_sse_context_size() + SIMD_ALIGN);
     context->simd = align(SIMD_ALIGN, get_sse_context_size(), 
         ((void*)context + sizeof(Context)), get_sse_context_size() + SIMD_ALIGN);
     
     set_initial_sse_context(context->simd);
+    context->simd_dirty = false;
+    context->simd_cpu = -1;
+    context->tls = 0;
     return context;
 }
 
@@ -30,7 +35,14 @@ void DestroyContext(Context* context) {
     kfree(context);
 }
 
-void unoptimized context_init(Context* context, uintptr_t ip, uintptr_t sp, uintptr_t ksp, ContextFlags cflags) {
+// *Prepare the context of a task that never ran. The first switch to the task resumes the interrupt frame
+// *built on top of its kernel stack
+// @param context the context to initialize
+// @param ip the entry point of the task
+// @param sp the user stack of the task
+// @param ksp the kernel stack of the task, used by syscalls, interrupts from user mode and kernel tasks
+// @param cflags the context flags
+void context_init(Context* context, uintptr_t ip, uintptr_t sp, uintptr_t ksp, ContextFlags cflags) {
     Registers regs;
     memory_set((uint8_t*)&regs, 0, sizeof(Registers));
 
@@ -47,19 +59,67 @@ void unoptimized context_init(Context* context, uintptr_t ip, uintptr_t sp, uint
         regs.rbp = PROCESS_STACK_BASE;
     }
 
-    regs.rsp = (uint64_t)sp;
-    context->regs = regs;
+    regs.rsp = (uint64_t)(IsUserTask(cflags) ? sp : ksp);
     context->syscall_kstack = ksp;
+    context->frame = (Registers*)((ksp - sizeof(Registers)) & ~0xf);
+    *context->frame = regs;
 }
 
-void unoptimized context_save(Context* context, Registers const* regs) {
-    save_sse_context(context->simd);
-    context->regs = *regs;
+// *Set the argument given to the entry point of a task that never ran
+// @param context the context initialized by context_init()
+// @param argument the value of the first argument
+void context_set_argument(Context* context, uintptr_t argument) {
+    context->frame->rdi = argument;
 }
 
-void unoptimized context_load(Context* context, Registers* regs) {
-    syscall_set_gs((uintptr_t)context);
+// *Set the thread local storage pointer of a task, loaded on its next switch
+// @param context the context of the task
+// @param tls the address of the thread local storage
+void context_set_tls(Context* context, uintptr_t tls) {
+    context->tls = tls;
+}
+
+// *Save the state of a task being switched out. The registers are left on its kernel stack, only the frame is
+// *recorded. The SIMD state is saved only if the task used it since it was scheduled
+// @param context the context of the task
+// @param regs the interrupt frame of the task
+void context_save(Context* context, Registers* regs) {
+    if (context->simd_dirty) {
+        save_sse_context(context->simd);
+        context->simd_dirty = false;
+    }
+
+    context->frame = regs;
+}
+
+// *Prepare the CPU to resume a task. The SIMD state is restored lazily, by context_simd_trap() on its first use,
+// *unless the SIMD registers of the CPU still hold it
+// @param context the context of the task
+// @return the interrupt frame to resume, which becomes the new stack pointer
+Registers* context_load(Context* context) {
+    Cpu* cpu = get_current_cpu();
+    syscall_set_gs((uintptr_t)context, (context->frame->cs & 3) == 0);
+    cpu->tss.rsp0 = context->syscall_kstack;
+    write_msr(FS_BASE, context->tls);
+
+    if (cpu->simd_owner == context && context->simd_cpu == (int32_t)cpu->id) {
+        simd_trap_disable();
+        context->simd_dirty = true;
+    } else {
+        simd_trap_enable();
+    }
+
+    return context->frame;
+}
+
+// *Handle the #NM exception raised by the first SIMD instruction of a task, restoring its SIMD state
+void context_simd_trap() {
+    Cpu* cpu = get_current_cpu();
+    Context* context = cpu->tasks.current->context;
+    simd_trap_disable();
 
-    *regs = context->regs;
     load_sse_context(context->simd);
+    context->simd_dirty = true;
+    context->simd_cpu = cpu->id;
+    cpu->simd_owner = context;
 }
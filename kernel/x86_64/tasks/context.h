@@ -2,6 +2,7 @@
 
 #include <neutrino/macros.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include "../interrupts.h"
 #include "kernel/common/tasks/context.h"
 
@@ -9,8 +10,11 @@ struct __context {
     uintptr_t syscall_kstack; 
     uintptr_t syscall_ustack; 
 
-    Registers regs;
+    Registers* frame;       // interrupt frame the task was switched out with, on top of its kernel stack
+    uintptr_t tls;          // thread local storage pointer, loaded in the FS base
     uint8_t* simd;
+    bool simd_dirty;        // the SIMD registers were given to the task since it was last saved
+    int32_t simd_cpu;       // CPU whose SIMD registers hold the latest state of the task, or -1
 };
 
 #define RFLAGS_INTERRUPT_ENABLE     (1<<9)
@@ -18,5 +22,9 @@ struct __context {
 
 #define SIMD_ALIGN  64
 
-void context_save(struct __context* context, const Registers* regs);
-void context_load(struct __context* context, Registers* regs);
+// the FS base is loaded on every switch: a non-canonical address would fault in the switch path
+#define CONTEXT_TLS_END     0x0000800000000000
+
+void context_save(struct __context* context, Registers* regs);
+Registers* context_load(struct __context* context);
+void context_simd_trap();
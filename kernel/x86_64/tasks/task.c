@@ -6,7 +6,7 @@
 #include <neutrino/macros.h>
 #include <stdbool.h>
 
-void unoptimized task_set_stack(Task* task, bool user) {
+void task_set_stack(Task* task, bool user) {
     task->stack_base = (uintptr_t)pmm_alloc_series(PROCESS_STACK_SIZE / PAGE_SIZE);     
 
     // set task head to terminator 
@@ -17,7 +17,40 @@ void unoptimized task_set_stack(Task* task, bool user) {
     
     vmm_unmap_page(0, get_mem_address(task_terminator));
 
+    // kernel tasks run on their kernel stack, which returns to the terminator as well
+    *(uintptr_t*)TaskKernelStackTop(task) = (uintptr_t)sched_terminate;
+
     // map the stack into task space
-    space_map(task->space, task->stack_base, PROCESS_STACK_BASE, PROCESS_STACK_SIZE / PAGE_SIZE, 
+    space_map(task->space, task->stack_base, task->stack_virt, PROCESS_STACK_SIZE / PAGE_SIZE, 
               (user) ? MAP_USER | MAP_WRITABLE : MAP_WRITABLE);
 }
+
+// *Give a thread the first free stack slot of its space and map its stack there
+// @param task the thread to set the stack of
+// @param user true if the stack is accessible from user mode
+// @return false if every slot of the space is in use, true otherwise
+bool task_set_thread_stack(Task* task, bool user) {
+    Space* space = task->space;
+
+    lock(&space->lock);
+    if (~space->thread_stacks == 0) {
+        unlock(&space->lock);
+        return false;
+    }
+
+    task->stack_slot = __builtin_ctzll(~space->thread_stacks);
+    space->thread_stacks |= (1ull << task->stack_slot);
+    unlock(&space->lock);
+
+    task->stack_virt = ThreadStackBase(task->stack_slot);
+    task_set_stack(task, user);
+    return true;
+}
+
+// *Unmap the stack of a thread from its space, which may be still used by other threads, and free its slot
+// @param task the thread to free the stack of
+void task_free_thread_stack(Task* task) {
+    space_unmap(task->space, task->stack_virt);
+    LockOperation(task->space->lock, task->space->thread_stacks &= ~(1ull << task->stack_slot));
+    task->stack_slot = -1;
+}
@@ -12,9 +12,11 @@
 
 #define ALLOC_MARKER_MAGIC	0xc001c0de
 #define ALLOC_MARKER_DEAD	0xdeaddead
+#define ALLOC_MARKER_LARGE	0x1a76eb10
 
 #define ALLOC_PAGE_SIZE 0x1000			// The size of an individual page. Set up in liballoc_init.
 #define ALLOC_PAGE_COUNT 16			    // The number of pages to request per chunk. Set up in liballoc_init.
+#define ALLOC_LARGE_THRESHOLD (ALLOC_PAGE_SIZE * ALLOC_PAGE_COUNT / 2)	// Requests from this size get their own pages, outside of any major block.
 
 typedef struct __alloc_major AllocMajor;
 typedef struct __alloc_minor AllocMinor;
@@ -46,7 +48,8 @@ extern int liballoc_lock();
 extern int liballoc_unlock();
 extern void* liballoc_alloc(size_t);
 extern int liballoc_free(void*,size_t);
-extern bool liballoc_try_lock();
+extern void* liballoc_alloc_large(size_t);
+extern int liballoc_free_large(void*,size_t);
     
 extern void* Prefix(malloc)(size_t);
 extern void* Prefix(realloc)(void*, size_t);
@@ -74,6 +74,27 @@ static AllocMajor* alloc_new_page(uint32_t size) {
 
 // ----------------------------------------------------------------
 
+// Large requests are given their own pages, returned to the system as soon as they are freed.
+static void* alloc_new_large(uint64_t size, uint64_t req_size) {
+	uint32_t pages = (size + sizeof(AllocMinor) + ALLOC_PAGE_SIZE - 1) / ALLOC_PAGE_SIZE;
+	AllocMinor* min = (AllocMinor*)liballoc_alloc_large(pages);
+	if (min == nullptr) return nullptr;
+
+	min->magic = ALLOC_MARKER_LARGE;
+	min->size = pages * ALLOC_PAGE_SIZE;
+	min->req_size = req_size;
+	min->prev = nullptr;
+	min->next = nullptr;
+	min->block = nullptr;
+
+	void* p = (void*)((uintptr_t)min + sizeof(AllocMinor));
+	ALIGN(p);
+
+	return p;
+}
+
+// ----------------------------------------------------------------
+
 void* Prefix(malloc)(size_t req_size) {
 	uint64_t size = req_size;
 
@@ -82,6 +103,8 @@ void* Prefix(malloc)(size_t req_size) {
 		size += ALIGNMENT + ALIGN_INFO;
 	// So, ideally, we really want an alignment of 0 or 1 in order
 	// to save space.
+
+	if (size >= ALLOC_LARGE_THRESHOLD) return alloc_new_large(size, req_size);
 	
 	liballoc_lock();
 
@@ -298,10 +321,17 @@ void Prefix(free)(void* ptr) {
 	if (ptr == nullptr) return;
 	
 	UNALIGN(ptr);
-	liballoc_lock();		// lockit
-
 	min = (AllocMinor*)((uintptr_t)ptr - sizeof(AllocMinor));
 
+	// Large allocations own their pages, no block to clean up.
+	if (min->magic == ALLOC_MARKER_LARGE) {
+		min->magic = ALLOC_MARKER_DEAD;
+		liballoc_free_large(min, min->size / ALLOC_PAGE_SIZE);
+		return;
+	}
+
+	liballoc_lock();		// lockit
+
 	if (min->magic != ALLOC_MARKER_MAGIC) {		
 		liballoc_unlock();		// release the lock
 		return;
@@ -371,7 +401,7 @@ void* Prefix(realloc)(void* p, size_t size) {
 	min = (AllocMinor*)((uintptr_t)ptr - sizeof( AllocMinor ));
 
 	// Ensure it is a valid structure.
-	if (min->magic != ALLOC_MARKER_MAGIC) {		
+	if (min->magic != ALLOC_MARKER_MAGIC && min->magic != ALLOC_MARKER_LARGE) {		
 		liballoc_unlock();		// release the lock
 		return NULL;
 	}	
@@ -1,25 +1,39 @@
 #include <neutrino/lock.h>
 #include <stdbool.h>
 #include <neutrino/syscall.h>
+#ifdef __kernel
+#include "kernel/common/memory/memory.h"
+#include "kernel/common/spinlock.h"
+#endif
 
 #define LIBALLOC_HEAP_START 0xffffffff80000000
 #define LIBALLOC_HEAP_END   0xffffffffffffffff
 
-static Lock kalloc_lock = NewLock;
+static TicketLock kalloc_lock = NewNamedTicketLock("kalloc");
 
-bool liballoc_try_lock() {
-    return try_lock((Lock*)&kalloc_lock);
+#ifdef __kernel
+// interrupt handlers never allocate, and freeing large blocks waits for the TLB shootdown of the other CPUs,
+// so the kernel heap is locked with interrupts enabled but without being preempted
+int liballoc_lock() {
+    ticket_lock_preempt(&kalloc_lock);
+    return 0;
 }
 
+int liballoc_unlock() {
+    ticket_unlock_preempt(&kalloc_lock);
+    return 0;
+}
+#else
 int liballoc_lock() {
-    lock(&kalloc_lock);
+    ticket_lock(&kalloc_lock);
     return 0;
 }
 
 int liballoc_unlock() {
-    unlock(&kalloc_lock);
+    ticket_unlock(&kalloc_lock);
     return 0;
 }
+#endif
 
 void* liballoc_alloc(size_t pages) {
     SCAllocArgs alloc_args = (SCAllocArgs){.size = pages};
@@ -42,3 +56,20 @@ int liballoc_free(void* address, size_t pages) {
     return neutrino_free(&free_args);
 #endif
 }
+
+void* liballoc_alloc_large(size_t pages) {
+#ifdef __kernel
+    return (void*)memory_allocate_large(pages);
+#else
+    return liballoc_alloc(pages);
+#endif
+}
+
+int liballoc_free_large(void* address, size_t pages) {
+#ifdef __kernel
+    memory_free_large((uintptr_t)address, pages);
+    return 0;
+#else
+    return liballoc_free(address, pages);
+#endif
+}
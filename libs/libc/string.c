@@ -11,7 +11,7 @@ char bchars[] = {'0','1','2','3','4','5','6','7','8','9','A','B','C','D','E','F'
 // *Return the length of the given string [str]
 // @param str the string to be measured
 // @return the length of the string [str]
-unsigned int unoptimized strlen(const char str[]) {
+unsigned int strlen(const char str[]) {
     int l;
     for(l=0; str[l]!='\0'; l++);
     return l;
@@ -21,7 +21,7 @@ unsigned int unoptimized strlen(const char str[]) {
 // @param s1 the first string to compare
 // @param s2 the second string to compare
 // @return true if the strings are equal, false otherwise
-bool unoptimized strcmp(const char* s1, const char* s2) {
+bool strcmp(const char* s1, const char* s2) {
     bool result = false;
     for (size_t i=0; ; i++) {
         if (s1[i] != s2[i]) return false;
@@ -37,7 +37,7 @@ bool unoptimized strcmp(const char* s1, const char* s2) {
 // @param s2 the second string to compare
 // @param len the number of characters to compare
 // @return 0 if the strings are equal, >0 if a character in s1 is greater than a character in s2, <0 if a character in s1 is less than a character in s2
-int32_t unoptimized strncmp(const char* s1, const char* s2, size_t len) {
+int32_t strncmp(const char* s1, const char* s2, size_t len) {
     while (len && *s1 && (*s1 == *s2)) {
         ++s1;
         ++s2;
@@ -51,7 +51,7 @@ int32_t unoptimized strncmp(const char* s1, const char* s2, size_t len) {
 // @param src the string to be copied
 // @param dest the destination string
 // @return true if the copy was successful, false otherwise
-bool unoptimized strcpy(const char *src, char *dest) {
+bool strcpy(const char *src, char *dest) {
     if (dest == NULL || src == NULL) return false;
     char *temp = dest;
     while ((*temp++ = *src++)); 
@@ -63,7 +63,7 @@ bool unoptimized strcpy(const char *src, char *dest) {
 // @param base the base to convert the unsigned integer to
 // @param buf the buffer to use during the conversion
 // @return the converted string 
-char* unoptimized itoa(unsigned i, unsigned base, char* buf) {
+char* itoa(unsigned i, unsigned base, char* buf) {
     int pos = 0;
     int opos = 0;
     int top = 0;
@@ -94,7 +94,7 @@ char* unoptimized itoa(unsigned i, unsigned base, char* buf) {
 // @param base the base to convert the signed integer to
 // @param buf the buffer to use during the conversion
 // @return the converted string 
-void unoptimized itoa_s(int i, unsigned base, char* buf) {
+void itoa_s(int i, unsigned base, char* buf) {
     if (base > 16) return;
     if (i < 0) {
         *buf++ = '-';
@@ -108,7 +108,7 @@ void unoptimized itoa_s(int i, unsigned base, char* buf) {
 // @param base the base to convert the unsigned long to
 // @param buf the buffer to use during the conversion
 // @return the converted string 
-char* unoptimized ltoa(uint64_t i, unsigned base, char* buf) {
+char* ltoa(uint64_t i, unsigned base, char* buf) {
     int pos = 0;
     int opos = 0;
     int top = 0;
@@ -139,7 +139,7 @@ char* unoptimized ltoa(uint64_t i, unsigned base, char* buf) {
 // @param base the base to convert the signed long to
 // @param buf the buffer to use during the conversion
 // @return the converted string 
-void unoptimized ltoa_s(int64_t i, unsigned base, char* buf) {
+void ltoa_s(int64_t i, unsigned base, char* buf) {
     if (base > 16) return;
     if (i < 0) {
         *buf++ = '-';
@@ -153,7 +153,7 @@ void unoptimized ltoa_s(int64_t i, unsigned base, char* buf) {
 // @param buffer the buffer to use during the conversion
 // @param ... the arguments to be formatted in the string
 // @return the formatted string
-char* unoptimized strf(const char* istr, char buffer[], ...) {
+char* strf(const char* istr, char buffer[], ...) {
     if (!istr) return 0;
 
     va_list args;
@@ -167,7 +167,7 @@ char* unoptimized strf(const char* istr, char buffer[], ...) {
 // @param buffer the buffer to use during the conversion
 // @param args the arguments list to be formatted in the string
 // @return the formatted string
-char* unoptimized vstrf(const char* istr, char buffer[], va_list args) {
+char* vstrf(const char* istr, char buffer[], va_list args) {
     if (!istr) return 0;
 
     char *buffer_p = buffer;
@@ -261,7 +261,7 @@ char* unoptimized vstrf(const char* istr, char buffer[], va_list args) {
 // @param source the source memory pointer
 // @param dest the destination memory pointer
 // @param nbytes the number of bytes to copy
-void unoptimized memcpy(uint8_t *source, uint8_t *dest, int nbytes) {
+void memcpy(uint8_t *source, uint8_t *dest, int nbytes) {
     int i;
     for (i = 0; i < nbytes; i++) {
         *(dest + i) = *(source + i);
@@ -272,7 +272,7 @@ void unoptimized memcpy(uint8_t *source, uint8_t *dest, int nbytes) {
 // @param dest the memory location to set bytes
 // @param val the value to set the bytes to
 // @param len the number of bytes to set
-void unoptimized memset(uint8_t *dest, uint8_t val, uint32_t len) {
+void memset(uint8_t *dest, uint8_t val, uint32_t len) {
     uint8_t *temp = (uint8_t *)dest;
     for ( ; len != 0; len--) *temp++ = val;
 }
@@ -0,0 +1,60 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CPU_MASK_BITS   64      // highest number of CPUs a mask can describe
+#define CPU_MASK_WORDS  ((CPU_MASK_BITS + 63) / 64)
+
+typedef struct __cpu_mask {
+    uint64_t bits[CPU_MASK_WORDS];   // bit n is set when CPU n is in the mask
+} CpuMask;
+
+#define NewCpuMask  (CpuMask){{0}}
+
+// *Add a CPU to a mask
+// @param mask the mask to update
+// @param cpu the id of the CPU to add
+static inline void cpu_mask_set(CpuMask* mask, uint32_t cpu) {
+    if (cpu < CPU_MASK_BITS) mask->bits[cpu / 64] |= (1ull << (cpu % 64));
+}
+
+// *Remove a CPU from a mask
+// @param mask the mask to update
+// @param cpu the id of the CPU to remove
+static inline void cpu_mask_clear(CpuMask* mask, uint32_t cpu) {
+    if (cpu < CPU_MASK_BITS) mask->bits[cpu / 64] &= ~(1ull << (cpu % 64));
+}
+
+// *Get if a CPU is in a mask
+// @param mask the mask to check
+// @param cpu the id of the CPU
+// @return true if the CPU is in the mask, false otherwise
+static inline bool cpu_mask_test(const CpuMask* mask, uint32_t cpu) {
+    return cpu < CPU_MASK_BITS && (mask->bits[cpu / 64] & (1ull << (cpu % 64))) != 0;
+}
+
+// *Get a mask with the first [count] CPUs set
+// @param count the number of CPUs in the mask
+// @return the new mask
+static inline CpuMask cpu_mask_first(uint32_t count) {
+    CpuMask mask = NewCpuMask;
+    for (uint32_t cpu = 0; cpu < count && cpu < CPU_MASK_BITS; cpu++) cpu_mask_set(&mask, cpu);
+    return mask;
+}
+
+// *Get the CPUs in both the given masks
+// @return the intersection of the masks
+static inline CpuMask cpu_mask_and(const CpuMask* a, const CpuMask* b) {
+    CpuMask mask;
+    for (uint32_t i = 0; i < CPU_MASK_WORDS; i++) mask.bits[i] = a->bits[i] & b->bits[i];
+    return mask;
+}
+
+// *Get if a mask has no CPU
+// @param mask the mask to check
+// @return true if the mask is empty, false otherwise
+static inline bool cpu_mask_is_empty(const CpuMask* mask) {
+    for (uint32_t i = 0; i < CPU_MASK_WORDS; i++)
+        if (mask->bits[i] != 0) return false;
+    return true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <stdint.h>
+
+#define LOAD_FIXED_SHIFT    11                      // load averages are fixed point numbers
+#define LOAD_FIXED_1        (1ull << LOAD_FIXED_SHIFT)
+#define LOAD_AVERAGES       3                       // averages over 1, 5 and 15 seconds
+
+#define TOP_NAME_MAX        64
+
+typedef struct __cpu_time {
+    uint64_t user;                      // time spent running in user mode
+    uint64_t kernel;                    // time spent running in kernel mode, syscalls and interrupts included
+    uint64_t idle;                      // time spent in the idle task
+} CpuTime;
+
+typedef struct __top_task {
+    uint32_t pid;
+    uint32_t cpu_id;                    // last CPU the task ran on
+    uint32_t status;
+    uint8_t priority;                   // current priority level
+    char name[TOP_NAME_MAX+1];
+    CpuTime time;                       // in nanoseconds
+} TopTask;
+
+typedef struct __top_cpu {
+    CpuTime time;                       // in nanoseconds
+    uint64_t load[LOAD_AVERAGES];       // average number of runnable tasks, see LOAD_FIXED_1
+    uint32_t utilisation;               // busy time over the last sample, per mille
+    uint32_t runnable;                  // tasks currently running or queued
+} TopCpu;
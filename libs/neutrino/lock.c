@@ -1,9 +1,64 @@
 #include "lock.h"
 #include <neutrino/macros.h>
-#include <neutrino/atomic.h>
+
+#ifdef __lockstat
+// named locks that were taken at least once, the most recent first
+LockStat* volatile lockstat_registry = nullptr;
+
+#define LockStatStart(s)            uint64_t s = 0;
+#define LockStatContended(s)        if (s == 0) s = lockstat_cycles();
+#define LockStatAcquired(l, s)      lockstat_acquired(&(l)->stat, s, (uintptr_t)__builtin_return_address(0));
+#else
+#define LockStatStart(s)
+#define LockStatContended(s)
+#define LockStatAcquired(l, s)
+#endif
 
 // === PRIVATE FUNCTIONS ========================
 
+#ifdef __lockstat
+static inline uint64_t lockstat_cycles() {
+    uint32_t low, high;
+    asm volatile("rdtsc" : "=a"(low), "=d"(high));
+    return ((uint64_t)high << 32) | low;
+}
+
+// *Add a named lock to the report the first time it's taken. A lock initialized again after being added is
+// *found in the registry and not added twice
+// @param stat the statistics of the lock
+static void lockstat_register(LockStat* stat) {
+    bool registered = false;
+    if (!__atomic_compare_exchange_n(&stat->registered, &registered, true, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+        return;
+
+    for (LockStat* s = __atomic_load_n(&lockstat_registry, __ATOMIC_ACQUIRE); s != nullptr; s = s->next) {
+        if (s == stat) return;
+    }
+
+    LockStat* head = __atomic_load_n(&lockstat_registry, __ATOMIC_RELAXED);
+    do {
+        stat->next = head;
+    } while (!__atomic_compare_exchange_n(&lockstat_registry, &head, stat, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+// *Record an acquisition of a lock. Called by the new holder, which is the only one writing the statistics
+// @param stat the statistics of the lock
+// @param spin_start the cycle counter when the caller started waiting, 0 if the lock was free
+// @param holder the return address of the caller
+static void lockstat_acquired(LockStat* stat, uint64_t spin_start, uintptr_t holder) {
+    if (stat->name != nullptr && !stat->registered) lockstat_register(stat);
+
+    stat->acquisitions++;
+    stat->holder = holder;
+    if (spin_start == 0) return;
+
+    uint64_t spin = lockstat_cycles() - spin_start;
+    stat->contended++;
+    stat->spin_cycles += spin;
+    if (spin > stat->max_spin) stat->max_spin = spin;
+}
+#endif
+
 // === PUBLIC FUNCTIONS =========================
 
 //* Initialize the lock to UNLOCKED
@@ -12,27 +67,117 @@ void lock_init(Lock *lock) {
     lock->flag = UNLOCKED;
 }
 
-// *Lock a spinlock, avoiding other threads accessing it
+// *Lock a spinlock, avoiding other threads accessing it. Waiters spin on a plain read, so that the cache line
+// *is only written when the lock looks free
 // @param lock the lock to be locked
-void unoptimized lock(Lock* lock) {
-    while (atomic_test_and_set((volatile uint8_t*)&(lock->flag))) {
-        asm volatile ("pause");
-        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+void lock(Lock* lock) {
+    LockStatStart(spin_start)
+    while (__atomic_test_and_set(&lock->flag, __ATOMIC_ACQUIRE)) {
+        LockStatContended(spin_start)
+        while (__atomic_load_n(&lock->flag, __ATOMIC_RELAXED) != UNLOCKED)
+            asm volatile ("pause");
     }
-    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    LockStatAcquired(lock, spin_start)
 }
 
 // *Unlock a spinlock and make it available to other threads
 // @param lock the lock to be unlocked
-void unoptimized unlock(Lock* lock) {
-    __atomic_thread_fence(__ATOMIC_SEQ_CST);
-    atomic_release((volatile uint8_t*)&(lock->flag));
+void unlock(Lock* lock) {
+    __atomic_clear(&lock->flag, __ATOMIC_RELEASE);
 }
 
 // *Return true if the lock is UNLOCKED
 // @param lock the lock to be checked
 // @return true if the lock is UNLOCKED, false otherwise
-bool unoptimized try_lock(Lock *lock) {
-    __atomic_thread_fence(__ATOMIC_SEQ_CST);
-    return (atomic_get_byte((volatile uintptr_t)(volatile uint8_t*)&(lock->flag)) == UNLOCKED);
+bool try_lock(Lock *lock) {
+    return (__atomic_load_n(&lock->flag, __ATOMIC_ACQUIRE) == UNLOCKED);
+}
+
+// --- Ticket locks -----------------------------
+
+// *Lock a ticket lock. Callers are served in the order they took their ticket
+// @param lock the lock to be locked
+void ticket_lock(TicketLock* lock) {
+    uint16_t ticket = __atomic_fetch_add(&lock->next, 1, __ATOMIC_RELAXED);
+
+    LockStatStart(spin_start)
+    while (__atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE) != ticket) {
+        LockStatContended(spin_start)
+        asm volatile ("pause");
+    }
+
+    LockStatAcquired(lock, spin_start)
+}
+
+// *Unlock a ticket lock, serving the next ticket. Only the holder writes the owner
+// @param lock the lock to be unlocked
+void ticket_unlock(TicketLock* lock) {
+    __atomic_store_n(&lock->owner, (uint16_t)(lock->owner + 1), __ATOMIC_RELEASE);
+}
+
+// *Lock a ticket lock only if nobody holds it or waits for it
+// @param lock the lock to be locked
+// @return true if the lock was taken, false otherwise
+bool ticket_try_lock(TicketLock* lock) {
+    uint16_t owner = __atomic_load_n(&lock->owner, __ATOMIC_RELAXED);
+    uint16_t next = owner;
+
+    // no ticket was given since [owner] was served, the lock is free
+    if (!__atomic_compare_exchange_n(&lock->next, &next, (uint16_t)(owner + 1), false, 
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        return false;
+
+    LockStatStart(spin_start)
+    LockStatAcquired(lock, spin_start)
+    return true;
+}
+
+// *Get if a ticket lock is held
+// @param lock the lock to be checked
+// @return true if the lock is held, false otherwise
+bool ticket_is_locked(TicketLock* lock) {
+    return __atomic_load_n(&lock->next, __ATOMIC_RELAXED) != __atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE);
+}
+
+// --- MCS locks --------------------------------
+
+// *Lock an MCS lock, queueing [node] behind the last waiter and spinning on it until the previous holder
+// *hands the lock over
+// @param lock the lock to be locked
+// @param node the queue node of the caller, valid until mcs_unlock() returns
+void mcs_lock(McsLock* lock, McsNode* node) {
+    node->next = nullptr;
+    node->locked = true;
+
+    LockStatStart(spin_start)
+    McsNode* prev = __atomic_exchange_n(&lock->tail, node, __ATOMIC_ACQ_REL);
+
+    if (prev != nullptr) {
+        LockStatContended(spin_start)
+        __atomic_store_n(&prev->next, node, __ATOMIC_RELEASE);
+        while (__atomic_load_n(&node->locked, __ATOMIC_ACQUIRE))
+            asm volatile ("pause");
+    }
+
+    LockStatAcquired(lock, spin_start)
+}
+
+// *Unlock an MCS lock, handing it over to the next waiter
+// @param lock the lock to be unlocked
+// @param node the node given to mcs_lock()
+void mcs_unlock(McsLock* lock, McsNode* node) {
+    McsNode* next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE);
+
+    if (next == nullptr) {
+        McsNode* expected = node;
+        if (__atomic_compare_exchange_n(&lock->tail, &expected, nullptr, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+            return;
+
+        // a waiter swapped the tail but didn't link itself yet
+        while ((next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE)) == nullptr)
+            asm volatile ("pause");
+    }
+
+    __atomic_store_n(&next->locked, false, __ATOMIC_RELEASE);
 }
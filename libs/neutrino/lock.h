@@ -7,17 +7,75 @@
 #define LOCKED      1
 #define UNLOCKED    0
 
+#ifdef __lockstat
+// contention statistics of a lock, updated by its holder. Built only with LOCKSTAT=1
+typedef struct __lock_stat {
+    const char* name;           // locks are listed in the report only when named
+    uint64_t acquisitions;
+    uint64_t contended;         // acquisitions that had to wait
+    uint64_t spin_cycles;       // cycles spent waiting, over every acquisition
+    uint64_t max_spin;
+    uintptr_t holder;           // return address of the last caller taking the lock
+    volatile bool registered;
+    struct __lock_stat* next;   // next lock of the report
+} LockStat;
+
+#define LockStatField           LockStat stat;
+#define LockStatName(n)         .stat = {.name = n},
+#else
+#define LockStatField
+#define LockStatName(n)
+#endif
+
 typedef struct __lock {
     volatile uint8_t flag;
+    LockStatField
 } Lock;
 
-#define NewLock         (Lock){UNLOCKED}
+// fair spinlock: callers take a ticket and are served in order
+typedef struct __ticket_lock {
+    volatile uint16_t next;     // ticket given to the next caller
+    volatile uint16_t owner;    // ticket currently holding the lock
+    LockStatField
+} TicketLock;
+
+// queued spinlock: every waiter spins on its own node, so that a release only touches the cache line of the next one
+typedef struct __mcs_node {
+    struct __mcs_node* volatile next;
+    volatile bool locked;
+} McsNode;
+
+typedef struct __mcs_lock {
+    McsNode* volatile tail;     // last waiter, nullptr if the lock is free
+    LockStatField
+} McsLock;
+
+#define NewLock         (Lock){.flag = UNLOCKED}
+#define NewTicketLock   (TicketLock){.next = 0, .owner = 0}
+#define NewMcsLock      (McsLock){.tail = nullptr}
+
+// locks given a name are listed by the lock statistics report
+#define NewNamedLock(n)         (Lock){LockStatName(n) .flag = UNLOCKED}
+#define NewNamedTicketLock(n)   (TicketLock){LockStatName(n) .next = 0, .owner = 0}
+#define NewNamedMcsLock(n)      (McsLock){LockStatName(n) .tail = nullptr}
 
 void lock_init(Lock *lock);
 void lock(Lock* lock);
 void unlock(Lock* lock);
 bool try_lock(Lock *lock);
 
+void ticket_lock(TicketLock* lock);
+void ticket_unlock(TicketLock* lock);
+bool ticket_try_lock(TicketLock* lock);
+bool ticket_is_locked(TicketLock* lock);
+
+void mcs_lock(McsLock* lock, McsNode* node);
+void mcs_unlock(McsLock* lock, McsNode* node);
+
+#ifdef __lockstat
+extern LockStat* volatile lockstat_registry;
+#endif
+
 static inline void retainer_release(Lock** l) {
     if (l != nullptr) {
         unlock(*l);
@@ -35,3 +93,38 @@ static inline void retainer_release(Lock** l) {
 #define LockOperation(l, operation)         lock(&l);           \
                                             operation;          \
                                             unlock(&l);
+
+static inline void ticket_retainer_release(TicketLock** l) {
+    if (l != nullptr && *l != nullptr) {
+        ticket_unlock(*l);
+        *l = nullptr;
+    }
+}
+
+#define _TicketRetain(ret, l)    \
+    TicketLock* ret cleanup(ticket_retainer_release) = l;    \
+    ticket_lock(ret);
+
+// *Lock the ticket lock [l] until the enclosing scope ends
+#define TicketRetain(l)    \
+    _TicketRetain(Concat(ticket_retainer, __COUNTER__), &l)
+
+typedef struct __mcs_guard {
+    McsLock* lock;
+    McsNode node;
+} McsGuard;
+
+static inline void mcs_retainer_release(McsGuard* guard) {
+    if (guard->lock != nullptr) {
+        mcs_unlock(guard->lock, &guard->node);
+        guard->lock = nullptr;
+    }
+}
+
+#define _McsRetain(ret, l)    \
+    McsGuard ret cleanup(mcs_retainer_release) = {.lock = l};    \
+    mcs_lock(ret.lock, &ret.node);
+
+// *Lock the MCS lock [l] until the enclosing scope ends, queueing on a node in the stack of the caller
+#define McsRetain(l)    \
+    _McsRetain(Concat(mcs_retainer, __COUNTER__), &l)
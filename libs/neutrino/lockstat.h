@@ -0,0 +1,19 @@
+#pragma once
+#include <stdint.h>
+
+#define LOCKSTAT_NAME_MAX   32
+
+typedef struct __lock_stat_entry {
+    char name[LOCKSTAT_NAME_MAX];
+    uint64_t acquisitions;
+    uint64_t contended;                 // acquisitions that had to wait
+    uint64_t spin_cycles;               // cycles spent waiting, over every acquisition
+    uint64_t max_spin;
+    uintptr_t holder;                   // return address of the last caller taking the lock
+} LockStatEntry;
+
+typedef enum __lock_stats_command {
+    LOCK_STATS_RESET,
+    LOCK_STATS_READ,
+    LOCK_STATS_DUMP
+} LockStatsCommand;
@@ -1,10 +1,12 @@
 #pragma once
 
-#define unoptimized     __attribute__((optimize("O0")))
 #define packed          __attribute__((packed))
 #define aligned(align)  __attribute__((aligned(align)))
 #define cleanup(func)  __attribute__((cleanup(func)))
 
+#define likely(x)       __builtin_expect(!!(x), 1)
+#define unlikely(x)     __builtin_expect(!!(x), 0)
+
 #define Max(a,b)        ((a > b) ? a : b)
 #define Min(a,b)        ((a < b) ? a : b)
 
@@ -0,0 +1,31 @@
+#pragma once
+#include <stdint.h>
+
+#define SCHED_HISTOGRAM_BUCKETS 32      // bucket n counts samples in [2^n, 2^(n+1)) cycles
+
+typedef struct __sched_histogram {
+    uint64_t count;
+    uint64_t total;                     // sum of every sample, in cycles
+    uint64_t max;
+    uint64_t buckets[SCHED_HISTOGRAM_BUCKETS];
+} SchedHistogram;
+
+typedef struct __sched_task_stats {
+    uint64_t wait_cycles;               // time spent runnable in a run queue
+    uint64_t run_cycles;                // time spent running on a CPU
+    uint64_t switches;                  // times the task was switched in
+    uint64_t wakeups;                   // times the task was woken up after blocking
+} SchedTaskStats;
+
+typedef struct __sched_cpu_stats {
+    SchedHistogram wakeup_latency;      // from the wakeup of a blocked task to its first cycle on the CPU
+    SchedHistogram timer_handler;       // duration of the context switch done by the timer handler
+} SchedCpuStats;
+
+typedef enum __sched_stats_command {
+    SCHED_STATS_ENABLE,
+    SCHED_STATS_DISABLE,
+    SCHED_STATS_RESET,
+    SCHED_STATS_READ,
+    SCHED_STATS_DUMP
+} SchedStatsCommand;
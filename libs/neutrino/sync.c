@@ -0,0 +1,120 @@
+#include "sync.h"
+#include <neutrino/syscall.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// the kernel blocks on wait queues, these primitives are only built for user tasks
+#ifndef __kernel
+
+#define SYNC_WAKE_ALL   0xffffffff
+
+// === PRIVATE FUNCTIONS ========================
+
+static inline void futex_wait(volatile uint32_t* address, uint32_t expected) {
+    neutrino_futex(&(SCFutexArgs){.op = FUTEX_WAIT, .address = address, .value = expected});
+}
+
+static inline void futex_wake(volatile uint32_t* address, uint32_t count) {
+    neutrino_futex(&(SCFutexArgs){.op = FUTEX_WAKE, .address = address, .value = count});
+}
+
+// === PUBLIC FUNCTIONS =========================
+
+// --- Mutexes ----------------------------------
+
+// *Lock a mutex, blocking the task while another one holds it
+// @param mutex the mutex to be locked
+void mutex_lock(Mutex* mutex) {
+    uint32_t state = MUTEX_UNLOCKED;
+    if (__atomic_compare_exchange_n(&mutex->state, &state, MUTEX_LOCKED, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        return;
+
+    // from now on the mutex is marked as contended, so that the holder wakes a waiter when unlocking it
+    if (state != MUTEX_CONTENDED) state = __atomic_exchange_n(&mutex->state, MUTEX_CONTENDED, __ATOMIC_ACQUIRE);
+    while (state != MUTEX_UNLOCKED) {
+        futex_wait(&mutex->state, MUTEX_CONTENDED);
+        state = __atomic_exchange_n(&mutex->state, MUTEX_CONTENDED, __ATOMIC_ACQUIRE);
+    }
+}
+
+// *Lock a mutex only if it's free
+// @param mutex the mutex to be locked
+// @return true if the mutex was locked, false otherwise
+bool mutex_try_lock(Mutex* mutex) {
+    uint32_t state = MUTEX_UNLOCKED;
+    return __atomic_compare_exchange_n(&mutex->state, &state, MUTEX_LOCKED, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+// *Unlock a mutex, waking up a waiting task if there may be one
+// @param mutex the mutex to be unlocked
+void mutex_unlock(Mutex* mutex) {
+    if (__atomic_exchange_n(&mutex->state, MUTEX_UNLOCKED, __ATOMIC_RELEASE) == MUTEX_CONTENDED)
+        futex_wake(&mutex->state, 1);
+}
+
+// --- Condition variables ----------------------
+
+// *Unlock a mutex and wait for a signal on a condition variable, then lock the mutex again.
+// *Wakeups may be spurious, the condition must be checked again on return
+// @param cond the condition variable to wait on
+// @param mutex the mutex protecting the condition, held by the caller
+void cond_wait(CondVar* cond, Mutex* mutex) {
+    uint32_t sequence = __atomic_load_n(&cond->sequence, __ATOMIC_RELAXED);
+    mutex_unlock(mutex);
+
+    // a signal sent after the unlock changes the sequence, the futex doesn't block then
+    futex_wait(&cond->sequence, sequence);
+
+    // other waiters may be woken up by a broadcast, the mutex is taken as contended to wake them in turn
+    while (__atomic_exchange_n(&mutex->state, MUTEX_CONTENDED, __ATOMIC_ACQUIRE) != MUTEX_UNLOCKED)
+        futex_wait(&mutex->state, MUTEX_CONTENDED);
+}
+
+// *Wake up a task waiting on a condition variable
+// @param cond the condition variable
+void cond_signal(CondVar* cond) {
+    __atomic_add_fetch(&cond->sequence, 1, __ATOMIC_RELEASE);
+    futex_wake(&cond->sequence, 1);
+}
+
+// *Wake up every task waiting on a condition variable
+// @param cond the condition variable
+void cond_broadcast(CondVar* cond) {
+    __atomic_add_fetch(&cond->sequence, 1, __ATOMIC_RELEASE);
+    futex_wake(&cond->sequence, SYNC_WAKE_ALL);
+}
+
+// --- Semaphores -------------------------------
+
+// *Take a unit of a semaphore only if one is available
+// @param sem the semaphore
+// @return true if a unit was taken, false otherwise
+bool sem_try_wait(Semaphore* sem) {
+    uint32_t count = __atomic_load_n(&sem->count, __ATOMIC_RELAXED);
+
+    while (count > 0) {
+        if (__atomic_compare_exchange_n(&sem->count, &count, count - 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            return true;
+    }
+
+    return false;
+}
+
+// *Take a unit of a semaphore, blocking the task until one is available
+// @param sem the semaphore
+void sem_wait(Semaphore* sem) {
+    while (!sem_try_wait(sem)) {
+        __atomic_add_fetch(&sem->waiters, 1, __ATOMIC_SEQ_CST);
+        futex_wait(&sem->count, 0);
+        __atomic_sub_fetch(&sem->waiters, 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+// *Give back a unit of a semaphore, waking up a waiting task if there's one
+// @param sem the semaphore
+void sem_post(Semaphore* sem) {
+    __atomic_add_fetch(&sem->count, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&sem->waiters, __ATOMIC_SEQ_CST) > 0) futex_wake(&sem->count, 1);
+}
+
+#endif
@@ -0,0 +1,39 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+// Blocking synchronisation for user tasks, built on the futex syscall. Uncontended operations are a single
+// atomic instruction and never enter the kernel
+
+#define MUTEX_UNLOCKED      0
+#define MUTEX_LOCKED        1
+#define MUTEX_CONTENDED     2   // locked, and tasks may be waiting for it in the kernel
+
+typedef struct __mutex {
+    volatile uint32_t state;
+} Mutex;
+
+typedef struct __cond_var {
+    volatile uint32_t sequence;     // incremented by every signal, waiters sleep until it changes
+} CondVar;
+
+typedef struct __semaphore {
+    volatile uint32_t count;
+    volatile uint32_t waiters;      // tasks waiting in the kernel, posts only enter it when there's one
+} Semaphore;
+
+#define NewMutex            (Mutex){MUTEX_UNLOCKED}
+#define NewCondVar          (CondVar){0}
+#define NewSemaphore(n)     (Semaphore){n, 0}
+
+void mutex_lock(Mutex* mutex);
+bool mutex_try_lock(Mutex* mutex);
+void mutex_unlock(Mutex* mutex);
+
+void cond_wait(CondVar* cond, Mutex* mutex);
+void cond_signal(CondVar* cond);
+void cond_broadcast(CondVar* cond);
+
+void sem_wait(Semaphore* sem);
+bool sem_try_wait(Semaphore* sem);
+void sem_post(Semaphore* sem);
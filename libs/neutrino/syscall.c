@@ -33,7 +33,7 @@ SyscallResult neutrino_log(SCLogArgs* args) {
     return neutrino_syscall(NEUTRINO_LOG, (uintptr_t)args, 0, 0, 0, 0);
 }
 
-SyscallResult neutrino_destroy_task(uintptr_t* args) {
+SyscallResult neutrino_destroy_task(SCExitArgs* args) {
     return neutrino_syscall(NEUTRINO_KILL_TASK, (uintptr_t)args, 0, 0, 0, 0);
 }
 
@@ -52,3 +52,67 @@ SyscallResult neutrino_free(SCFreeArgs* args) {
 SyscallResult neutrino_ipc(SCIpcArgs* args) {
     return neutrino_syscall(NEUTRINO_IPC, (uintptr_t)args, 0, 0, 0, 0);
 }
+
+SyscallResult neutrino_set_priority(SCPriorityArgs* args) {
+    return neutrino_syscall(NEUTRINO_SET_PRIORITY, (uintptr_t)args, 0, 0, 0, 0);
+}
+
+SyscallResult neutrino_sched_stats(SCSchedStatsArgs* args) {
+    return neutrino_syscall(NEUTRINO_SCHED_STATS, (uintptr_t)args, 0, 0, 0, 0);
+}
+
+SyscallResult neutrino_get_affinity(SCAffinityArgs* args) {
+    return neutrino_syscall(NEUTRINO_GET_AFFINITY, (uintptr_t)args, 0, 0, 0, 0);
+}
+
+SyscallResult neutrino_set_affinity(SCAffinityArgs* args) {
+    return neutrino_syscall(NEUTRINO_SET_AFFINITY, (uintptr_t)args, 0, 0, 0, 0);
+}
+
+SyscallResult neutrino_wait(SCWaitArgs* args) {
+    return neutrino_syscall(NEUTRINO_WAIT, (uintptr_t)args, 0, 0, 0, 0);
+}
+
+SyscallResult neutrino_thread_create(SCThreadArgs* args) {
+    return neutrino_syscall(NEUTRINO_THREAD_CREATE, (uintptr_t)args, 0, 0, 0, 0);
+}
+
+SyscallResult neutrino_thread_join(SCWaitArgs* args) {
+    return neutrino_syscall(NEUTRINO_THREAD_JOIN, (uintptr_t)args, 0, 0, 0, 0);
+}
+
+SyscallResult neutrino_yield(uintptr_t* args) {
+    return neutrino_syscall(NEUTRINO_YIELD, (uintptr_t)args, 0, 0, 0, 0);
+}
+
+SyscallResult neutrino_sleep(SCSleepArgs* args) {
+    return neutrino_syscall(NEUTRINO_SLEEP, (uintptr_t)args, 0, 0, 0, 0);
+}
+
+SyscallResult neutrino_set_deadline(SCDeadlineArgs* args) {
+    return neutrino_syscall(NEUTRINO_SET_DEADLINE, (uintptr_t)args, 0, 0, 0, 0);
+}
+
+SyscallResult neutrino_get_deadline(SCDeadlineArgs* args) {
+    return neutrino_syscall(NEUTRINO_GET_DEADLINE, (uintptr_t)args, 0, 0, 0, 0);
+}
+
+SyscallResult neutrino_top(SCTopArgs* args) {
+    return neutrino_syscall(NEUTRINO_TOP, (uintptr_t)args, 0, 0, 0, 0);
+}
+
+SyscallResult neutrino_task_list(SCTaskListArgs* args) {
+    return neutrino_syscall(NEUTRINO_TASK_LIST, (uintptr_t)args, 0, 0, 0, 0);
+}
+
+SyscallResult neutrino_task_info(SCTaskInfoArgs* args) {
+    return neutrino_syscall(NEUTRINO_TASK_INFO, (uintptr_t)args, 0, 0, 0, 0);
+}
+
+SyscallResult neutrino_lock_stats(SCLockStatsArgs* args) {
+    return neutrino_syscall(NEUTRINO_LOCK_STATS, (uintptr_t)args, 0, 0, 0, 0);
+}
+
+SyscallResult neutrino_futex(SCFutexArgs* args) {
+    return neutrino_syscall(NEUTRINO_FUTEX, (uintptr_t)args, 0, 0, 0, 0);
+}
@@ -4,6 +4,11 @@
 #include <size_t.h>
 #include <ipc/ipc.h>
 #include <neutrino/time.h>
+#include <neutrino/schedstat.h>
+#include <neutrino/cpumask.h>
+#include <neutrino/cputime.h>
+#include <neutrino/taskinfo.h>
+#include <neutrino/lockstat.h>
 #include <neutrino/macros.h>
 
 #define FOREACH_SYSCALL(c) \
@@ -13,6 +18,22 @@
     c(NEUTRINO_ALLOC) \
     c(NEUTRINO_FREE) \
     c(NEUTRINO_IPC) \
+    c(NEUTRINO_SET_PRIORITY) \
+    c(NEUTRINO_SCHED_STATS) \
+    c(NEUTRINO_GET_AFFINITY) \
+    c(NEUTRINO_SET_AFFINITY) \
+    c(NEUTRINO_WAIT) \
+    c(NEUTRINO_THREAD_CREATE) \
+    c(NEUTRINO_THREAD_JOIN) \
+    c(NEUTRINO_YIELD) \
+    c(NEUTRINO_SLEEP) \
+    c(NEUTRINO_SET_DEADLINE) \
+    c(NEUTRINO_GET_DEADLINE) \
+    c(NEUTRINO_TOP) \
+    c(NEUTRINO_TASK_LIST) \
+    c(NEUTRINO_TASK_INFO) \
+    c(NEUTRINO_LOCK_STATS) \
+    c(NEUTRINO_FUTEX) \
 
 // Syscall enum
 typedef enum __neutrino_syscalls {
@@ -43,6 +64,10 @@ typedef struct __sc_log_args {
     char* msg;
 } SCLogArgs;
 
+typedef struct __sc_exit_args {
+    uint32_t status;
+} SCExitArgs;
+
 typedef struct __sc_now_args {
     Timestamp timestamp;
 } SCNowArgs;
@@ -65,6 +90,86 @@ typedef struct __sc_ipc_args {
     size_t size;
 } SCIpcArgs;
 
+typedef struct __sc_priority_args {
+    uint32_t pid;
+    uint8_t priority;
+} SCPriorityArgs;
+
+typedef struct __sc_sched_stats_args {
+    SchedStatsCommand command;
+    uint32_t cpu_id;
+    SchedTaskStats task;
+    SchedCpuStats cpu;
+} SCSchedStatsArgs;
+
+typedef struct __sc_affinity_args {
+    uint32_t pid;
+    CpuMask allowed;
+    CpuMask preferred;
+} SCAffinityArgs;
+
+typedef struct __sc_wait_args {
+    uint32_t pid;
+    uint32_t status;
+} SCWaitArgs;
+
+typedef struct __sc_thread_args {
+    uintptr_t entry;
+    uintptr_t argument;
+    uintptr_t tls;
+    uint32_t tid;
+} SCThreadArgs;
+
+typedef struct __sc_sleep_args {
+    uint64_t ns;
+} SCSleepArgs;
+
+typedef struct __sc_deadline_args {
+    uint64_t runtime;
+    uint64_t deadline;
+    uint64_t period;
+    uint64_t misses;
+} SCDeadlineArgs;
+
+typedef struct __sc_top_args {
+    TopTask* tasks;
+    uint32_t task_count;
+    uint32_t total_tasks;
+    TopCpu* cpus;
+    uint32_t cpu_count;
+} SCTopArgs;
+
+typedef struct __sc_task_list_args {
+    uint32_t from;
+    TaskInfo* tasks;
+    uint32_t count;
+    uint32_t next;
+} SCTaskListArgs;
+
+typedef struct __sc_task_info_args {
+    uint32_t pid;
+    TaskInfo info;
+} SCTaskInfoArgs;
+
+typedef struct __sc_lock_stats_args {
+    LockStatsCommand command;
+    LockStatEntry* entries;
+    uint32_t count;
+    uint32_t total;
+} SCLockStatsArgs;
+
+typedef enum __futex_op {
+    FUTEX_WAIT,
+    FUTEX_WAKE
+} FutexOp;
+
+typedef struct __sc_futex_args {
+    FutexOp op;
+    volatile uint32_t* address;
+    uint32_t value;
+    uint32_t woken;
+} SCFutexArgs;
+
 // === Syscall prototypes ===
 
 // Log a string message to the debug serial output
@@ -73,9 +178,9 @@ typedef struct __sc_ipc_args {
 SysCall(log)(SCLogArgs* args);
 
 // Destroy the current task. This is a TRAP syscall, control is lost and returned to kernel
-// @param args unused argument
+// @param status IN the exit status given to the parent task. If args is nullptr, the status is QUIT_SUCCESS
 // @return SYSCALL_FAILURE on call failure (scheduler fails to terminate task)
-SysCall(destroy_task)(uintptr_t* args);
+SysCall(destroy_task)(SCExitArgs* args);
 
 // Return the current timestamp. Note this is not the same as UNIX timestamp
 // @param timestamp OUT the current timestamp 
@@ -94,9 +199,133 @@ SysCall(alloc)(SCAllocArgs* args);
 // @return SYSCALL_SUCCESS on success; SYSCALL_INVALID if size = 0 or pointer is nullptr; SYSCALL_FAILURE if heap manager fails
 SysCall(free)(SCFreeArgs* args);
 
-// Send an IPC message (between different processes)
-// @param type IN the type of the IPC call (SEND, RECEIVE, BROADCAST)
+// Send an IPC message (between different processes). RECEIVE blocks the task until a message is available, PEEK never blocks
+// @param type IN the type of the IPC call (SEND, RECEIVE, PEEK, BROADCAST)
 // @param data IN/OUT the data to be sent/received. This is an output field when type is RECEIVE, input otherwise
 // @param size IN/OUT the size of the sent/received data. This is an output field when type is RECEIVE, input otherwise 
 // @return SYSCALL_SUCCESS on success; SYSCALL_UNAUTHORIZED if task channel does not allow IPCs; SYSCALL_FAILURE if IPC fails
 SysCall(ipc)(SCIpcArgs* args);
+
+// Set the base scheduling priority of a task. Levels go from 0 (highest) to 7 (lowest)
+// @param pid IN the pid of the task
+// @param priority IN the new priority level
+// @return SYSCALL_SUCCESS on success; SYSCALL_INVALID if priority is out of range or no task has the pid;
+// @return SYSCALL_UNAUTHORIZED if a user task targets a kernel task
+SysCall(set_priority)(SCPriorityArgs* args);
+
+// Control the scheduler statistics. Statistics are only collected between ENABLE and DISABLE. User tasks can only READ
+// @param command IN the operation (ENABLE, DISABLE, RESET, READ, DUMP). DUMP prints every statistic on the serial output
+// @param cpu_id IN the CPU to read the histograms of, on READ
+// @param task OUT the statistics of the calling task, on READ
+// @param cpu OUT the histograms of the CPU [cpu_id], on READ
+// @return SYSCALL_SUCCESS on success; SYSCALL_INVALID if command or cpu_id are not valid;
+// @return SYSCALL_UNAUTHORIZED if a user task sends any command but READ
+SysCall(sched_stats)(SCSchedStatsArgs* args);
+
+// Get the CPUs a task can run on (hard affinity) and the CPUs it prefers to run on (soft affinity)
+// @param pid IN the pid of the task
+// @param allowed OUT the CPUs the task can run on
+// @param preferred OUT the CPUs chosen first when the task has to move
+// @return SYSCALL_SUCCESS on success; SYSCALL_INVALID if no task has the pid;
+// @return SYSCALL_UNAUTHORIZED if a user task targets a kernel task
+SysCall(get_affinity)(SCAffinityArgs* args);
+
+// Set the CPUs a task can run on and the CPUs it prefers. If its CPU is no longer allowed, the calling task is moved
+// at once, any other task on its next scheduler cycle
+// @param pid IN the pid of the task
+// @param allowed IN the CPUs the task can run on, CPUs that are not online are ignored
+// @param preferred IN the CPUs chosen first when the task has to move, an empty mask means no preference
+// @return SYSCALL_SUCCESS on success; SYSCALL_INVALID if no task has the pid or no allowed CPU is online;
+// @return SYSCALL_UNAUTHORIZED if a user task targets a kernel task
+SysCall(set_affinity)(SCAffinityArgs* args);
+
+// Block until a task started by the calling task is destroyed, then collect its exit status.
+// The status of a task can be collected once, and only until its parent is destroyed
+// @param pid IN the pid of the task to wait for
+// @param status OUT the exit status of the task
+// @return SYSCALL_SUCCESS on success; SYSCALL_INVALID if no such task exists; SYSCALL_UNAUTHORIZED if the task is not a child of the caller
+SysCall(wait)(SCWaitArgs* args);
+
+// Create a thread of the calling task, sharing its address space and IPC channel. The thread has its own stack
+// and runs [entry] with [argument] as the first argument. It terminates by returning from [entry] or with destroy_task
+// @param entry IN the function run by the thread
+// @param argument IN the argument given to the function
+// @param tls IN the thread local storage pointer, loaded in the FS base of the thread. Must be a user space address
+// @param tid OUT the pid of the new thread
+// @return SYSCALL_SUCCESS on success; SYSCALL_INVALID if entry is nullptr or tls is not a user space address;
+// @return SYSCALL_FAILURE if the task has too many threads
+SysCall(thread_create)(SCThreadArgs* args);
+
+// Block until a thread created by the calling task terminates, then collect its exit status
+// @param pid IN the pid of the thread to join
+// @param status OUT the exit status of the thread
+// @return SYSCALL_SUCCESS on success; SYSCALL_INVALID if no such thread exists; SYSCALL_UNAUTHORIZED if the thread was created by another task
+SysCall(thread_join)(SCWaitArgs* args);
+
+// Give up the CPU to the other tasks of the same priority level. The task is queued again at once
+// @param args unused argument
+// @return SYSCALL_SUCCESS once the task runs again
+SysCall(yield)(uintptr_t* args);
+
+// Block the task for a period of time, without using the CPU. The task is woken up on the first timer interrupt after the deadline
+// @param ns IN the minimum sleep duration, in nanoseconds
+// @return SYSCALL_SUCCESS once the task runs again; SYSCALL_INVALID if ns is 0
+SysCall(sleep)(SCSleepArgs* args);
+
+// Move the current task to the deadline class, running before every other task: a job of runtime ns is released every period ns,
+// and should be completed within deadline ns of its release by yielding. The task is throttled when it runs out of budget
+// @param runtime IN the budget of every job, in nanoseconds. 0 moves the task back to the normal class
+// @param deadline IN the relative deadline of every job, in nanoseconds, between runtime and period
+// @param period IN the time between two job releases, in nanoseconds
+// @return SYSCALL_SUCCESS on success; SYSCALL_INVALID if the parameters are not valid; SYSCALL_FAILURE if no CPU has enough free bandwidth
+SysCall(set_deadline)(SCDeadlineArgs* args);
+
+// Get the deadline parameters of the current task
+// @param runtime OUT the budget of every job, in nanoseconds. 0 if the task is not in the deadline class
+// @param deadline OUT the relative deadline of every job, in nanoseconds
+// @param period OUT the time between two job releases, in nanoseconds
+// @param misses OUT the number of jobs completed late or not completed before the next release
+// @return SYSCALL_SUCCESS on success
+SysCall(get_deadline)(SCDeadlineArgs* args);
+
+// Take a snapshot of the CPU time used by every task, and of the time and load of every CPU
+// @param tasks IN the entries filled with the tasks, may be nullptr if task_count is 0
+// @param task_count IN the number of task entries; OUT the number of filled task entries
+// @param total_tasks OUT the number of tasks, which may be more than the filled entries
+// @param cpus IN the entries filled with the CPUs, may be nullptr if cpu_count is 0
+// @param cpu_count IN the number of CPU entries; OUT the number of filled CPU entries
+// @return SYSCALL_SUCCESS on success; SYSCALL_INVALID if an entry buffer is nullptr while its count is not 0
+SysCall(top)(SCTopArgs* args);
+
+// List the tasks with their state, in pid order. Long lists are read in several calls, starting each one from [next]
+// @param from IN the first pid to list
+// @param tasks IN the entries filled with the tasks
+// @param count IN the number of entries; OUT the number of filled entries, less than requested once every task is listed
+// @param next OUT the pid the next call should start from
+// @return SYSCALL_SUCCESS on success; SYSCALL_INVALID if tasks is nullptr
+SysCall(task_list)(SCTaskListArgs* args);
+
+// Get the state of a task
+// @param pid IN the pid of the task
+// @param info OUT the state of the task
+// @return SYSCALL_SUCCESS on success; SYSCALL_INVALID if no task has the pid
+SysCall(task_info)(SCTaskInfoArgs* args);
+
+// Control the kernel lock contention statistics, collected only by kernels built with LOCKSTAT=1
+// @param command IN the operation (RESET, READ, DUMP). DUMP prints the statistics of every named lock on the serial output
+// @param entries IN the entries filled with the named locks, on READ
+// @param count IN the number of entries; OUT the number of filled entries, on READ
+// @param total OUT the number of named locks, which may be more than the filled entries, on READ
+// @return SYSCALL_SUCCESS on success; SYSCALL_INVALID if command is not valid or entries is nullptr on READ;
+//         SYSCALL_FAILURE if the kernel doesn't collect lock statistics
+SysCall(lock_stats)(SCLockStatsArgs* args);
+
+// Wait on a 32 bit word of the calling task memory, or wake up the tasks waiting on it. Threads sharing the
+// address space share the futexes. WAIT blocks only if the word still holds [value], checked atomically with the wakeups
+// @param op IN the operation (WAIT, WAKE)
+// @param address IN the futex, aligned on 4 bytes and mapped readable in the calling task memory on WAIT
+// @param value IN the value the futex is expected to hold, on WAIT; the maximum number of tasks to wake up, on WAKE
+// @param woken OUT the number of woken up tasks, on WAKE
+// @return SYSCALL_SUCCESS on success, once woken up on WAIT; SYSCALL_INVALID if op or address are not valid;
+//         SYSCALL_FAILURE if the futex doesn't hold value on WAIT, the caller should check it again
+SysCall(futex)(SCFutexArgs* args);
@@ -0,0 +1,30 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TASK_INFO_NAME_MAX  64
+
+typedef enum __task_status {
+    TASK_EMBRYO,            // task is creating its Context and Space
+    TASK_NEW,               // task has never been executed before
+    TASK_READY,             // task is ready for execution
+    TASK_RUNNING,           // task is running
+    TASK_BLOCKED,           // task is waiting on a wait queue and can't be scheduled
+    TASK_ZOMBIE             // task is ended and freeing its resources
+} TaskStatus;
+
+typedef enum __sched_class {
+    SCHED_CLASS_NORMAL,     // multi-level feedback priorities
+    SCHED_CLASS_DEADLINE    // earliest deadline first, runs before every normal task
+} SchedClass;
+
+typedef struct __task_info {
+    uint32_t pid;
+    uint32_t parent_pid;                // 0xffffffff for tasks started by the kernel
+    uint32_t status;                    // see TaskStatus
+    uint32_t sched_class;               // see SchedClass
+    uint32_t cpu_id;                    // last CPU the task ran on
+    uint8_t priority;                   // current priority level
+    bool user;
+    char name[TASK_INFO_NAME_MAX+1];
+} TaskInfo;
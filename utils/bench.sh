@@ -0,0 +1,132 @@
+#!/bin/sh
+# Boot benchmark: builds the default (-O1) and the optimised (-O2, LTO) kernels with AUTORUN=1, boots both
+# under QEMU and compares their serial logs. The check fails if either kernel doesn't finish the benchmarks,
+# if the programs of the initrd behave differently on the two kernels, if the CPUs don't run tasks in parallel,
+# or if the optimised kernel is slower. A third kernel, built with IDLE_MWAIT=0, gives the cross-CPU wakeup
+# latency of the HLT idle loop, which must be slower than MONITOR/MWAIT when the CPU has it.
+#
+# usage: utils/bench.sh [timeout in seconds, 180 by default]
+
+set -u
+
+TIMEOUT=${1:-180}
+QEMU=${QEMU:-qemu-system-x86_64}
+HARD_FLAGS="-m 4G -vga std -cpu Skylake-Client -smp 4"
+OUT=./bench
+DONE_MARK="Kernel benchmark finished"
+LOCKBENCH_MARK="futex mutex:"
+SMPTEST_MARK="CPU overlap:"
+WAKEBENCH_MARK="wakebench cross-CPU wakeup:"
+
+fail() {
+    echo "[BENCH] FAILED: $1"
+    exit 1
+}
+
+# build_profile <name> <make flags...>
+build_profile() {
+    name=$1; shift
+    echo "[BENCH] Building the $name kernel..."
+    make --no-print-directory "$@" AUTORUN=1 clear > /dev/null || fail "cannot clean the $name build"
+    make --no-print-directory "$@" AUTORUN=1 cd > "$OUT/$name.build.log" 2>&1 || fail "cannot build the $name kernel, see $OUT/$name.build.log"
+}
+
+# boot <name> <iso>: boot the kernel until the benchmarks and the SMP test are done, or until the timeout
+boot() {
+    log="$OUT/$1.serial.log"
+    rm -f "$log"
+    echo "[BENCH] Booting the $1 kernel..."
+
+    $QEMU -cdrom "$2" $HARD_FLAGS -display none -no-reboot -serial file:"$log" &
+    qemu=$!
+
+    elapsed=0
+    while [ $elapsed -lt "$TIMEOUT" ]; do
+        if grep -q "$DONE_MARK" "$log" 2>/dev/null && grep -q "$LOCKBENCH_MARK" "$log" 2>/dev/null &&
+           grep -q "$SMPTEST_MARK" "$log" 2>/dev/null && grep -q "$WAKEBENCH_MARK" "$log" 2>/dev/null; then
+            break
+        fi
+        if grep -q "\[FATAL\]" "$log" 2>/dev/null; then
+            break
+        fi
+        sleep 1
+        elapsed=$((elapsed + 1))
+    done
+
+    kill $qemu 2> /dev/null
+    wait $qemu 2> /dev/null
+
+    grep -q "\[FATAL\]" "$log" && fail "the $1 kernel panicked, see $log"
+    grep -q "$DONE_MARK" "$log" || fail "the $1 kernel didn't finish the benchmark in ${TIMEOUT}s, see $log"
+    grep -q "$LOCKBENCH_MARK" "$log" || fail "the $1 kernel didn't finish the lock benchmark in ${TIMEOUT}s, see $log"
+    grep -q "$SMPTEST_MARK" "$log" || fail "the $1 kernel didn't finish the SMP test in ${TIMEOUT}s, see $log"
+    grep -q "$WAKEBENCH_MARK" "$log" || fail "the $1 kernel didn't finish the wakeup benchmark in ${TIMEOUT}s, see $log"
+    echo "[BENCH] The $1 kernel booted and finished the benchmarks in ${elapsed}s"
+}
+
+# behaviour <log>: the output of the programs, without timings, addresses and the order of concurrent tasks
+behaviour() {
+    grep "^\[LOG\]" "$1" | grep -v "Syscall " | sed 's/0x[0-9a-fA-F]*/X/g; s/[0-9][0-9]*/N/g' | sort -u
+}
+
+# cycles <log>: the sum of the cycles per call of the kernel benchmarks
+cycles() {
+    sed -n 's/.*kbench .*: \([0-9][0-9]*\) cycles per call.*/\1/p' "$1" | awk '{ total += $1 } END { print total + 0 }'
+}
+
+# wakeup <log>: the average cycles from a futex wake to the woken task running on another CPU
+wakeup() {
+    sed -n "s/.*$WAKEBENCH_MARK \([0-9][0-9]*\) cycles on average.*/\1/p" "$1" | head -n 1
+}
+
+command -v "$QEMU" > /dev/null || fail "$QEMU is not installed"
+mkdir -p "$OUT"
+
+build_profile O1
+cp neutrino.iso "$OUT/neutrino-o1.iso"
+build_profile O2 OPTIMISE=1
+cp neutrino-o2.iso "$OUT/neutrino-o2.iso"
+build_profile HLT IDLE_MWAIT=0
+cp neutrino.iso "$OUT/neutrino-hlt.iso"
+
+boot O1 "$OUT/neutrino-o1.iso"
+boot O2 "$OUT/neutrino-o2.iso"
+boot HLT "$OUT/neutrino-hlt.iso"
+
+grep -h "kbench " "$OUT/O1.serial.log" "$OUT/O2.serial.log" | grep -v ", 0 failed" && fail "a kernel benchmark failed"
+grep -h "counter WRONG" "$OUT/O1.serial.log" "$OUT/O2.serial.log" && fail "a lock lost an update"
+for name in O1 O2; do
+    grep -q "$SMPTEST_MARK.*, correct" "$OUT/$name.serial.log" || fail "the CPUs of the $name kernel don't run tasks in parallel"
+done
+
+behaviour "$OUT/O1.serial.log" > "$OUT/O1.behaviour"
+behaviour "$OUT/O2.serial.log" > "$OUT/O2.behaviour"
+if ! diff -u "$OUT/O1.behaviour" "$OUT/O2.behaviour" > "$OUT/behaviour.diff"; then
+    fail "the kernels behave differently, see $OUT/behaviour.diff"
+fi
+echo "[BENCH] The programs of the initrd behave the same on both kernels"
+
+echo "[BENCH] Kernel paths, cycles per call:"
+grep -h "kbench .*cycles per call" "$OUT/O1.serial.log" | sed 's/.*kbench /    O1 /'
+grep -h "kbench .*cycles per call" "$OUT/O2.serial.log" | sed 's/.*kbench /    O2 /'
+echo "[BENCH] Lock benchmark:"
+grep -h "cycles per acquisition" "$OUT/O1.serial.log" | sed 's/.*\] /    O1 /'
+grep -h "cycles per acquisition" "$OUT/O2.serial.log" | sed 's/.*\] /    O2 /'
+
+o1=$(cycles "$OUT/O1.serial.log")
+o2=$(cycles "$OUT/O2.serial.log")
+echo "[BENCH] Total: O1 $o1 cycles, O2 $o2 cycles"
+[ "$o2" -lt "$o1" ] || fail "the optimised kernel is not faster"
+
+echo "[BENCH] Cross-CPU wakeup:"
+grep -h "$WAKEBENCH_MARK" "$OUT/O1.serial.log" | sed 's/.*: /    O1 /'
+grep -h "$WAKEBENCH_MARK" "$OUT/HLT.serial.log" | sed 's/.*: /    O1, HLT idle /'
+mwait=$(wakeup "$OUT/O1.serial.log")
+hlt=$(wakeup "$OUT/HLT.serial.log")
+if grep -q "Idle loop uses MONITOR/MWAIT" "$OUT/O1.serial.log"; then
+    [ -n "$mwait" ] && [ -n "$hlt" ] && [ "$mwait" -lt "$hlt" ] || fail "waking an idle CPU is not faster with MONITOR/MWAIT"
+else
+    echo "[BENCH] The CPU has no MONITOR/MWAIT, both kernels idle with HLT"
+fi
+
+echo "[BENCH] PASSED"